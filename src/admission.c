@@ -0,0 +1,105 @@
+#include <errno.h>
+#include <pthread.h>
+
+#include "systemf-internal.h"
+
+/*
+ * Admission control for the children of every run in the process.  Callers
+ * that have to wait take a ticket and are admitted in ticket order so a big
+ * pipeline can't be starved by a stream of small ones.
+ */
+static pthread_mutex_t admission_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t admission_cond = PTHREAD_COND_INITIALIZER;
+static int admission_max_children = 0; // <= 0 is unlimited.
+static int admission_flags = 0;
+static unsigned long admission_next_ticket = 0;
+static unsigned long admission_serving = 0;
+static systemf1_admission_stats admission_stats;
+
+/*
+ * A group bigger than the limit is let through on its own so it can still run.
+ */
+static int has_room(int count) {
+    return (admission_max_children <= 0) ||
+        (admission_stats.running == 0) ||
+        (admission_stats.running + count <= admission_max_children);
+}
+
+static void admit(int count) {
+    admission_stats.admitted++;
+    admission_stats.running += count;
+}
+
+int systemf1_admission_set(int max_children, int flags) {
+    int prev;
+
+    pthread_mutex_lock(&admission_lock);
+    prev = admission_max_children;
+    admission_max_children = max_children;
+    admission_flags = flags;
+    pthread_cond_broadcast(&admission_cond);
+    pthread_mutex_unlock(&admission_lock);
+
+    return prev;
+}
+
+void systemf1_admission_stats_get(systemf1_admission_stats *stats) {
+    pthread_mutex_lock(&admission_lock);
+    *stats = admission_stats;
+    stats->queued = admission_next_ticket - admission_serving;
+    pthread_mutex_unlock(&admission_lock);
+}
+
+/*
+ * Admits count children.  Waits for room unless try is set or the limit is in
+ * SYSTEMF1_ADMIT_TRY mode.  Returns 0 on success and -1 with errno set to
+ * EAGAIN when the children weren't admitted.
+ */
+int _sf1_admission_acquire(int count, int try) {
+    unsigned long ticket;
+    unsigned long long start, waited;
+
+    pthread_mutex_lock(&admission_lock);
+    if ((admission_next_ticket == admission_serving) && has_room(count)) {
+        admit(count);
+        pthread_mutex_unlock(&admission_lock);
+        return 0;
+    }
+    if (try || (admission_flags & SYSTEMF1_ADMIT_TRY)) {
+        admission_stats.rejected++;
+        pthread_mutex_unlock(&admission_lock);
+        errno = EAGAIN;
+        return -1;
+    }
+
+    ticket = admission_next_ticket++;
+    start = _sf1_now_ns();
+    while ((ticket != admission_serving) || !has_room(count)) {
+        pthread_cond_wait(&admission_cond, &admission_lock);
+    }
+    admission_serving++;
+    waited = _sf1_now_ns() - start;
+
+    admission_stats.waited++;
+    admission_stats.wait_ns += waited;
+    if (waited > admission_stats.max_wait_ns) {
+        admission_stats.max_wait_ns = waited;
+    }
+    admit(count);
+
+    // The next ticket may fit as well.
+    pthread_cond_broadcast(&admission_cond);
+    pthread_mutex_unlock(&admission_lock);
+
+    return 0;
+}
+
+/*
+ * Returns count children admitted by _sf1_admission_acquire().
+ */
+void _sf1_admission_release(int count) {
+    pthread_mutex_lock(&admission_lock);
+    admission_stats.running -= count;
+    pthread_cond_broadcast(&admission_cond);
+    pthread_mutex_unlock(&admission_lock);
+}
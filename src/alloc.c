@@ -0,0 +1,95 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "systemf-internal.h"
+
+static void *default_malloc(size_t size, void *ctx) {
+    return malloc(size);
+}
+
+static void *default_realloc(void *ptr, size_t size, void *ctx) {
+    return realloc(ptr, size);
+}
+
+static void default_free(void *ptr, void *ctx) {
+    free(ptr);
+}
+
+/*
+ * Only written by systemf1_set_allocator(), which callers keep from running
+ * alongside anything else in systemf.
+ */
+static struct {
+    systemf1_malloc_fn malloc_fn;
+    systemf1_realloc_fn realloc_fn;
+    systemf1_free_fn free_fn;
+    void *ctx;
+} allocator = { default_malloc, default_realloc, default_free, NULL };
+
+int systemf1_set_allocator(systemf1_malloc_fn malloc_fn, systemf1_realloc_fn realloc_fn,
+                           systemf1_free_fn free_fn, void *ctx) {
+    if ((!malloc_fn != !realloc_fn) || (!malloc_fn != !free_fn)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    // The cache would otherwise be freed by the new allocator.
+    _sf1_env_cache_flush();
+    if (!malloc_fn) {
+        malloc_fn = default_malloc;
+        realloc_fn = default_realloc;
+        free_fn = default_free;
+        ctx = NULL;
+    }
+    allocator.malloc_fn = malloc_fn;
+    allocator.realloc_fn = realloc_fn;
+    allocator.free_fn = free_fn;
+    allocator.ctx = ctx;
+    return 0;
+}
+
+void *_sf1_malloc(size_t size) {
+    return allocator.malloc_fn(size, allocator.ctx);
+}
+
+void *_sf1_calloc(size_t count, size_t size) {
+    void *ptr;
+
+    if (size && (count > (size_t) -1 / size)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    ptr = _sf1_malloc(count * size);
+    if (ptr) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void *_sf1_realloc(void *ptr, size_t size) {
+    if (!ptr) {
+        return _sf1_malloc(size);
+    }
+    return allocator.realloc_fn(ptr, size, allocator.ctx);
+}
+
+/*
+ * Like free(), NULL is ignored.  Allocators don't have to handle a NULL ptr
+ * here or in realloc_fn.
+ */
+void _sf1_free(void *ptr) {
+    if (ptr) {
+        allocator.free_fn(ptr, allocator.ctx);
+    }
+}
+
+char *_sf1_strdup(const char *s) {
+    size_t size = strlen(s) + 1;
+    char *copy = _sf1_malloc(size);
+
+    if (copy) {
+        memcpy(copy, s, size);
+    }
+    return copy;
+}
@@ -0,0 +1,342 @@
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+
+#include "systemf-internal.h"
+
+#if defined(__linux__) && defined(SYS_pidfd_open)
+#include <sys/epoll.h>
+#define HAVE_PIDFD 1
+#else
+#define HAVE_PIDFD 0
+#endif
+
+/*
+ * One pid of the group that is running.
+ */
+typedef struct {
+    int pidfd;        // -1 when it isn't in the epoll.
+    int reaped;
+} proc_pid;
+
+/*
+ * A run in progress.  Only systemf1_proc_poll(), systemf1_proc_wait(), and
+ * systemf1_proc_free() move it along, so nothing runs behind the caller's back.
+ */
+struct systemf1_proc_ {
+    _sf1_task *tasks;
+    _sf1_run run;
+    proc_pid *pids;
+    int pids_size;
+    int running;         // Pids in run.pid_chain that haven't been reaped.
+    int last_stat;       // Status of the last pid in run.pid_chain.
+    int epfd;            // Readable when a child of the group exits.  -1 without pidfds.
+    int done;
+};
+
+#if HAVE_PIDFD
+static int open_pidfd(pid_t pid) {
+    return _sf1_builtin_is(pid) ? _sf1_builtin_fd(pid) : syscall(SYS_pidfd_open, pid, 0);
+}
+#endif
+
+/*
+ * Stops watching the pidfd of pid i.  A child forked before it execs holds a
+ * copy of every pidfd, so closing it is not enough to remove it from the epoll.
+ */
+static void proc_unwatch(systemf1_proc *proc, int i) {
+    if (proc->pids[i].pidfd < 0) {
+        return;
+    }
+#if HAVE_PIDFD
+    epoll_ctl(proc->epfd, EPOLL_CTL_DEL, proc->pids[i].pidfd, NULL);
+#endif
+    close(proc->pids[i].pidfd);
+    proc->pids[i].pidfd = -1;
+}
+
+/*
+ * Sets up the pids of the group that was just launched and adds their pidfds to
+ * the epoll.  Returns -1 if they can't all be tracked.
+ */
+static int proc_watch(systemf1_proc *proc) {
+    _sf1_pid_chain_t *pid_chain = proc->run.pid_chain;
+
+    if (proc->pids_size < pid_chain->size) {
+        proc_pid *pids = _sf1_realloc(proc->pids, sizeof(proc_pid) * pid_chain->size);
+        if (!pids) {
+            return -1;
+        }
+        proc->pids = pids;
+        proc->pids_size = pid_chain->size;
+    }
+    for (int i = 0; i < pid_chain->size; i++) {
+        proc->pids[i] = (proc_pid) { .pidfd = -1, .reaped = 0 };
+    }
+    proc->running = pid_chain->size;
+
+#if HAVE_PIDFD
+    if (proc->epfd >= 0) {
+        for (int i = 0; i < pid_chain->size; i++) {
+            struct epoll_event event = { .events = EPOLLIN, .data.u32 = i };
+
+            proc->pids[i].pidfd = open_pidfd(pid_chain->pids[i]);
+            if (proc->pids[i].pidfd < 0) {
+                return -1;
+            }
+            if (epoll_ctl(proc->epfd, EPOLL_CTL_ADD, proc->pids[i].pidfd, &event)) {
+                close(proc->pids[i].pidfd);
+                proc->pids[i].pidfd = -1;
+                return -1;
+            }
+        }
+    }
+#endif
+    return 0;
+}
+
+static void proc_finish(systemf1_proc *proc) {
+    for (int i = 0; proc->run.pid_chain && (i < proc->run.pid_chain->size); i++) {
+        proc_unwatch(proc, i);
+    }
+    _sf1_debug_return("systemf1_start", NULL, _sf1_run_finish(&proc->run));
+    _sf1_task_free(proc->tasks);
+    proc->tasks = NULL;
+    proc->done = 1;
+}
+
+/*
+ * Launches groups until one is running.  Returns 1 if one is and 0 once the
+ * run has finished.
+ */
+static int proc_advance(systemf1_proc *proc) {
+    while (_sf1_run_launch(&proc->run) > 0) {
+        if (!proc_watch(proc)) {
+            return 1;
+        }
+        // Nothing can track the group, so it is killed.
+        fprintf(stderr, "systemf: %s watching the children\n", strerror(errno));
+        for (int i = 0; i < proc->run.pid_chain->size; i++) {
+            proc_unwatch(proc, i);
+        }
+        _sf1_pid_chain_kill(proc->run.pid_chain);
+        proc->run.retval = -1;
+        break;
+    }
+    proc_finish(proc);
+    return 0;
+}
+
+/*
+ * Records that pid i of the group exited with stat.  Returns 1 while the run
+ * is still going and 0 once it has finished.
+ */
+static int proc_reaped(systemf1_proc *proc, int i, int stat) {
+    _sf1_pid_chain_t *pid_chain = proc->run.pid_chain;
+
+    _SF1_PROBE(reap, pid_chain->pids[i], stat);
+    proc_unwatch(proc, i);
+    proc->pids[i].reaped = 1;
+    if (i == pid_chain->size - 1) {
+        proc->last_stat = stat;
+    }
+    if (--proc->running) {
+        return 1;
+    }
+    if (_sf1_run_reaped(&proc->run, proc->last_stat) || (proc->last_stat == -1)) {
+        if (proc->last_stat == -1) {
+            proc->run.retval = -1;
+        }
+        proc_finish(proc);
+        return 0;
+    }
+    return proc_advance(proc);
+}
+
+static systemf1_proc *proc_start(const systemf1_opts *opts, const char *fmt, _sf1_parse_args *args) {
+    systemf1_proc *proc;
+    unsigned long long call_id = _sf1_call_begin();
+    unsigned long long start = _sf1_now_ns();
+
+    proc = _sf1_calloc(1, sizeof(*proc));
+    if (!proc) {
+        return NULL;
+    }
+    proc->epfd = -1;
+
+    _SF1_PROBE(parse__start, fmt);
+    proc->tasks = _sf1_parse(fmt, args);
+    _SF1_PROBE(parse__end, fmt, proc->tasks != NULL);
+    _sf1_phase_end(call_id, SYSTEMF1_TRACE_PARSE, start, 0, proc->tasks ? 0 : -1);
+    if (!proc->tasks) {
+        _SF1_STAT(parse_errors);
+        _sf1_free(proc);
+        return NULL;
+    }
+    // Later groups are launched after the call returns, when the caller's
+    // strings may be gone.
+    if (_sf1_task_own_args(proc->tasks)) {
+        _sf1_task_free(proc->tasks);
+        _sf1_free(proc);
+        return NULL;
+    }
+
+#if HAVE_PIDFD
+    // Kernels before 5.3 have no pidfds.  Then there is no fd to wait on.
+    int pidfd = open_pidfd(getpid());
+    if (pidfd >= 0) {
+        close(pidfd);
+        proc->epfd = epoll_create1(EPOLL_CLOEXEC);
+    }
+#endif
+    if (_sf1_run_start(&proc->run, proc->tasks, opts, call_id)) {
+        _sf1_debug_return("systemf1_start", fmt, -1);
+        proc->run.retval = -1;
+        _sf1_task_free(proc->tasks);
+        proc->tasks = NULL;
+        proc->done = 1;
+        return proc;
+    }
+    proc_advance(proc);
+    return proc;
+}
+
+systemf1_proc *systemf1_start(const systemf1_opts *opts, const char *fmt, ...)
+{
+    va_list argp;
+    systemf1_proc *proc;
+
+    va_start(argp, fmt);
+    proc = systemf1_startv(opts, fmt, argp);
+    va_end(argp);
+
+    return proc;
+}
+
+systemf1_proc *systemf1_startv(const systemf1_opts *opts, const char *fmt, va_list ap)
+{
+    va_list argp;
+    _sf1_parse_args args = { .argpp = &argp };
+    systemf1_proc *proc;
+
+    // The lexer needs a va_list it can point to, and a va_list parameter may not be one.
+    va_copy(argp, ap);
+    proc = proc_start(opts, fmt, &args);
+    va_end(argp);
+
+    if (!proc) {
+        _sf1_debug_return(__func__, fmt, -1);
+    }
+    return proc;
+}
+
+systemf1_proc *systemf1_start_args(const systemf1_opts *opts, const char *fmt, const systemf1_arg *args,
+                                   size_t nargs)
+{
+    static const systemf1_arg none;
+    _sf1_parse_args parse_args = { .args = args ? args : &none, .nargs = nargs };
+    systemf1_proc *proc = proc_start(opts, fmt, &parse_args);
+
+    if (!proc) {
+        _sf1_debug_return(__func__, fmt, -1);
+    }
+    return proc;
+}
+
+int systemf1_proc_fd(const systemf1_proc *proc) {
+    return proc->epfd;
+}
+
+int systemf1_proc_poll(systemf1_proc *proc, int *result) {
+    _sf1_pid_chain_t *pid_chain;
+    int running = !proc->done;
+
+    // Reaping one pid may finish the group and launch the next, so start over.
+    for (int i = 0; running && (i < proc->run.pid_chain->size); i++) {
+        int stat;
+        pid_t pid;
+
+        pid_chain = proc->run.pid_chain;
+        if (proc->pids[i].reaped) {
+            continue;
+        }
+        pid = _sf1_waitpid(pid_chain->pids[i], &stat, WNOHANG);
+        if (pid == 0) {
+            continue;
+        }
+        if (pid != pid_chain->pids[i]) {
+            fprintf(stderr, "waitpid unexpectedly returned %s", strerror(errno));
+            stat = -1;
+        }
+        running = proc_reaped(proc, i, stat);
+        i = -1;
+    }
+    if (!running) {
+        if (result) {
+            *result = proc->run.retval;
+        }
+        return 0;
+    }
+    return 1;
+}
+
+int systemf1_proc_wait(systemf1_proc *proc) {
+    int result;
+
+    while (systemf1_proc_poll(proc, &result)) {
+        _sf1_pid_chain_t *pid_chain = proc->run.pid_chain;
+        unsigned long long start = _sf1_now_ns();
+        int i = 0;
+        int stat;
+        pid_t pid;
+
+        while (proc->pids[i].reaped) {
+            i++;
+        }
+        while (((pid = _sf1_waitpid(pid_chain->pids[i], &stat, 0)) < 0) && (errno == EINTR));
+        if (pid != pid_chain->pids[i]) {
+            fprintf(stderr, "waitpid unexpectedly returned %s", strerror(errno));
+            stat = -1;
+        }
+        _sf1_phase_end(proc->run.call_id, SYSTEMF1_TRACE_WAIT, start, pid_chain->pids[i], stat);
+        proc_reaped(proc, i, stat);
+    }
+    return result;
+}
+
+int systemf1_proc_kill(systemf1_proc *proc, int sig) {
+    if (proc->done) {
+        errno = ESRCH;
+        return -1;
+    }
+    // Whatever the group does with sig, nothing after it runs.
+    proc->run.next_task = NULL;
+    for (int i = 0; i < proc->run.pid_chain->size; i++) {
+        if (!proc->pids[i].reaped) {
+            _sf1_kill(proc->run.pid_chain->pids[i], sig);
+        }
+    }
+    return 0;
+}
+
+void systemf1_proc_free(systemf1_proc *proc) {
+    if (!proc) {
+        return;
+    }
+    if (!proc->done) {
+        systemf1_proc_kill(proc, SIGKILL);
+        systemf1_proc_wait(proc);
+    }
+    if (proc->epfd >= 0) {
+        close(proc->epfd);
+    }
+    _sf1_free(proc->pids);
+    _sf1_free(proc);
+}
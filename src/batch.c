@@ -0,0 +1,346 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+
+#include "systemf-internal.h"
+
+#if defined(__linux__) && defined(SYS_pidfd_open)
+#include <sys/epoll.h>
+#define HAVE_PIDFD 1
+#else
+#define HAVE_PIDFD 0
+#endif
+
+/*
+ * One item of the batch in progress.
+ */
+typedef struct {
+    _sf1_task *tasks;
+    _sf1_run run;
+    size_t index;     // Index into the results.
+    int running;      // Pids in run.pid_chain that haven't been reaped.
+    int last_stat;    // Status of the last pid in run.pid_chain.
+    int *pidfds;      // One per pid in run.pid_chain.
+    int pidfds_size;
+    int deferred;     // The next group is waiting to be admitted.
+} batch_slot;
+
+typedef struct {
+    const systemf1_opts *opts;
+    const char *fmt;
+    _sf1_task *template; // fmt parsed once.  Each item binds its arguments to it.
+    const systemf1_arg *args;
+    size_t nargs;
+    int *results;
+    int epfd;
+    int watching;     // Slots with pidfds in the epoll.
+} batch;
+
+#if HAVE_PIDFD
+static int open_pidfd(pid_t pid) {
+    return _sf1_builtin_is(pid) ? _sf1_builtin_fd(pid) : syscall(SYS_pidfd_open, pid, 0);
+}
+#endif
+
+/*
+ * Stops watching a pidfd.  A child forked before it execs holds a copy of every
+ * pidfd, so closing it is not enough to remove it from the epoll.
+ */
+static void slot_unwatch(batch *b, batch_slot *slot, int pid_index) {
+#if HAVE_PIDFD
+    if (b->epfd >= 0) {
+        epoll_ctl(b->epfd, EPOLL_CTL_DEL, slot->pidfds[pid_index], NULL);
+    }
+#endif
+    close(slot->pidfds[pid_index]);
+    slot->pidfds[pid_index] = -1;
+}
+
+static void slot_finish(batch *b, batch_slot *slot) {
+    b->results[slot->index] = _sf1_run_finish(&slot->run);
+    _sf1_task_free(slot->tasks);
+    slot->tasks = NULL;
+}
+
+/*
+ * Registers a pidfd for every pid of the slot's current group with the epoll.
+ * Returns -1 if pidfds or epoll are not usable.  In that case, nothing is registered.
+ */
+static int slot_watch(batch *b, batch_slot *slot, uint64_t slot_index) {
+#if HAVE_PIDFD
+    _sf1_pid_chain_t *pid_chain = slot->run.pid_chain;
+    int i;
+
+    if (b->epfd < 0) {
+        return -1;
+    }
+
+    if (slot->pidfds_size < pid_chain->size) {
+        int *pidfds = _sf1_realloc(slot->pidfds, sizeof(int) * pid_chain->size);
+        if (!pidfds) {
+            return -1;
+        }
+        slot->pidfds = pidfds;
+        slot->pidfds_size = pid_chain->size;
+    }
+
+    for (i = 0; i < pid_chain->size; i++) {
+        struct epoll_event event = {
+            .events = EPOLLIN,
+            .data.u64 = (slot_index << 32) | i,
+        };
+
+        slot->pidfds[i] = open_pidfd(pid_chain->pids[i]);
+        if (slot->pidfds[i] < 0) {
+            break;
+        }
+        if (epoll_ctl(b->epfd, EPOLL_CTL_ADD, slot->pidfds[i], &event)) {
+            close(slot->pidfds[i]);
+            break;
+        }
+    }
+    if (i < pid_chain->size) {
+        while (i--) {
+            slot_unwatch(b, slot, i);
+        }
+        return -1;
+    }
+    slot->running = pid_chain->size;
+    b->watching++;
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/*
+ * Launches the next group of the slot's tasks.  Groups that can't be watched
+ * through the epoll are waited for here.  Returns 1 while the slot is still
+ * running and 0 once it has finished.
+ *
+ * While the batch has children of its own, waiting to be admitted could wait on
+ * children only this thread reaps, so the slot is deferred instead.
+ */
+static int slot_advance(batch *b, batch_slot *slot, uint64_t slot_index) {
+    int stat;
+    int ret;
+
+    slot->deferred = 0;
+    slot->run.defer_admission = b->watching > 0;
+    while ((ret = _sf1_run_launch(&slot->run)) > 0) {
+        if (ret == _SF1_RUN_DEFERRED) {
+            slot->deferred = 1;
+            return 1;
+        }
+        if (!slot_watch(b, slot, slot_index)) {
+            return 1;
+        }
+        if (_sf1_pid_chain_waitpids(slot->run.pid_chain, &stat, 0) == 0) {
+            fprintf(stderr, "waitpid unexpectedly returned %s", strerror(errno));
+            slot->run.retval = -1;
+            break;
+        }
+        if (_sf1_run_reaped(&slot->run, stat)) {
+            break;
+        }
+    }
+    slot_finish(b, slot);
+    return 0;
+}
+
+/*
+ * Binds the arguments of item index to the template and starts it in the
+ * slot.  Returns 1 if the slot is running and 0 if the item has already finished.
+ */
+static int slot_start(batch *b, batch_slot *slot, uint64_t slot_index, size_t index) {
+    unsigned long long call_id = _sf1_call_begin();
+    unsigned long long start = _sf1_now_ns();
+
+    slot->index = index;
+    b->results[index] = -1;
+    slot->tasks = _sf1_template_bind(b->template, b->args + index * b->nargs);
+    _sf1_phase_end(call_id, SYSTEMF1_TRACE_PARSE, start, 0, slot->tasks ? 0 : -1);
+    if (!slot->tasks) {
+        return 0;
+    }
+    if (_sf1_run_start(&slot->run, slot->tasks, b->opts, call_id)) {
+        _sf1_task_free(slot->tasks);
+        slot->tasks = NULL;
+        return 0;
+    }
+    return slot_advance(b, slot, slot_index);
+}
+
+/*
+ * Starts items in the slot until one of them is running.  Returns 1 if one is
+ * and 0 if there are no items left.
+ */
+static int slot_fill(batch *b, batch_slot *slot, uint64_t slot_index, size_t *next, size_t count) {
+    while (*next < count) {
+        if (slot_start(b, slot, slot_index, (*next)++)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Handles a readable pidfd.  Returns 1 while the slot is still running and
+ * 0 once it has finished.
+ */
+static int slot_reap(batch *b, batch_slot *slot, uint64_t slot_index, int pid_index) {
+    _sf1_pid_chain_t *pid_chain = slot->run.pid_chain;
+    int stat;
+
+    slot_unwatch(b, slot, pid_index);
+    if (_sf1_waitpid(pid_chain->pids[pid_index], &stat, 0) != pid_chain->pids[pid_index]) {
+        fprintf(stderr, "waitpid unexpectedly returned %s", strerror(errno));
+        stat = -1;
+    }
+    _SF1_PROBE(reap, pid_chain->pids[pid_index], stat);
+    if (pid_index == pid_chain->size - 1) {
+        slot->last_stat = stat;
+    }
+
+    slot->running -= 1;
+    if (slot->running) {
+        return 1;
+    }
+    b->watching--;
+    if (slot->last_stat == -1) {
+        slot->run.retval = -1;
+    } else if (!_sf1_run_reaped(&slot->run, slot->last_stat)) {
+        return slot_advance(b, slot, slot_index);
+    }
+    slot_finish(b, slot);
+    return 0;
+}
+
+int systemf1_batch(const systemf1_opts *opts, const char *fmt, const systemf1_arg *args, size_t nargs,
+                   size_t count, int max_parallel, int *results)
+{
+    batch b = { .opts = opts, .fmt = fmt, .args = args, .nargs = nargs, .results = results, .epfd = -1 };
+    _sf1_parse_args parse_args = { .nargs = nargs, .is_template = 1 };
+    batch_slot *slots;
+    size_t next = 0;
+    int active = 0;
+
+    if (!fmt || !results || (!args && nargs)) {
+        errno = EINVAL;
+        return _sf1_debug_return(__func__, fmt, -1);
+    }
+    if (max_parallel <= 0) {
+        max_parallel = sysconf(_SC_NPROCESSORS_ONLN);
+        if (max_parallel <= 0) {
+            max_parallel = 1;
+        }
+    }
+    if ((size_t) max_parallel > count) {
+        max_parallel = count;
+    }
+    if (!max_parallel) {
+        return 0;
+    }
+
+    // Like systemf1(), a format that can't be parsed fails each item rather than the batch.
+    _SF1_PROBE(parse__start, fmt);
+    b.template = _sf1_parse(fmt, &parse_args);
+    _SF1_PROBE(parse__end, fmt, b.template != NULL);
+    if (!b.template) {
+        _SF1_STAT(parse_errors);
+        for (size_t i = 0; i < count; i++) {
+            results[i] = -1;
+        }
+        return 0;
+    }
+
+    slots = _sf1_calloc(max_parallel, sizeof(batch_slot));
+    if (!slots) {
+        _sf1_task_free(b.template);
+        return _sf1_debug_return(__func__, fmt, -1);
+    }
+
+#if HAVE_PIDFD
+    // Without the epoll, each group is waited for as it is launched.
+    b.epfd = epoll_create1(EPOLL_CLOEXEC);
+#endif
+
+    for (int i = 0; i < max_parallel; i++) {
+        active += slot_fill(&b, &slots[i], i, &next, count);
+    }
+
+#if HAVE_PIDFD
+    while (active) {
+        struct epoll_event events[16];
+        int n;
+
+        // Children may have been released since deferred slots last tried.  With
+        // nothing of ours left to reap, the first of them waits to be admitted.
+        for (int i = 0; i < max_parallel; i++) {
+            if (slots[i].deferred && !slot_advance(&b, &slots[i], i)) {
+                active -= !slot_fill(&b, &slots[i], i, &next, count);
+            }
+        }
+        if (!b.watching) {
+            continue;
+        }
+
+        n = epoll_wait(b.epfd, events, sizeof(events) / sizeof(events[0]), -1);
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Give up on the epoll.  What is left is reaped and run in order.
+            close(b.epfd);
+            b.epfd = -1;
+            for (int i = 0; i < max_parallel; i++) {
+                batch_slot *slot = &slots[i];
+                for (int p = 0; slot->tasks && !slot->deferred && (p < slot->run.pid_chain->size); p++) {
+                    if (slot->pidfds[p] >= 0) {
+                        slot_reap(&b, slot, i, p);
+                    }
+                }
+            }
+            for (int i = 0; i < max_parallel; i++) {
+                if (slots[i].deferred) {
+                    slot_advance(&b, &slots[i], i);
+                }
+            }
+            break;
+        }
+
+        for (int e = 0; e < n; e++) {
+            uint64_t slot_index = events[e].data.u64 >> 32;
+            int pid_index = events[e].data.u64 & 0xffffffff;
+            batch_slot *slot = &slots[slot_index];
+
+            if (!slot_reap(&b, slot, slot_index, pid_index)) {
+                active -= !slot_fill(&b, slot, slot_index, &next, count);
+            }
+        }
+    }
+    if (b.epfd >= 0) {
+        close(b.epfd);
+    }
+#endif
+
+    // Only reached with items left when they can't be watched through the epoll.
+    while (next < count) {
+        slot_start(&b, &slots[0], 0, next++);
+    }
+
+    for (int i = 0; i < max_parallel; i++) {
+        _sf1_free(slots[i].pidfds);
+    }
+    _sf1_free(slots);
+    _sf1_task_free(b.template);
+
+    return 0;
+}
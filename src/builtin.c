@@ -0,0 +1,314 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+#include "systemf-internal.h"
+
+/*
+ * A builtin registered with systemf1_register_builtin().
+ */
+typedef struct builtin_ {
+    char *name;
+    _sf1_builtin builtin;
+    struct builtin_ *next;
+} builtin;
+
+/*
+ * A builtin running in a thread.  Its id stands in for a pid in the run's
+ * pid_chain until it is reaped by _sf1_builtin_wait().
+ */
+typedef struct builtin_run_ {
+    pid_t id;
+    pthread_t thread;
+    _sf1_builtin builtin;
+    systemf1_builtin_call call;
+    int signaled;         // The signal it was sent, which is its status.
+    int done;             // Set once fn returned and the fds are closed.
+    int stat;
+    int efd;              // Readable once done.  -1 without eventfds.
+    int cancel;           // call.cancel, made readable when it is signaled.
+    struct builtin_run_ *next;
+} builtin_run;
+
+static builtin *builtins = NULL;
+static int builtin_count = 0;
+static pthread_mutex_t builtins_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static builtin_run *running = NULL;
+static pid_t next_id = _SF1_BUILTIN_PID;
+static pthread_mutex_t running_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int systemf1_register_builtin(const char *name, systemf1_builtin_fn fn, void *ctx) {
+    builtin **link;
+    builtin *b;
+
+    if (!name || !*name) {
+        errno = EINVAL;
+        return _sf1_debug_return(__func__, name, -1);
+    }
+
+    pthread_mutex_lock(&builtins_lock);
+    for (link = &builtins; *link && strcmp((*link)->name, name); link = &(*link)->next);
+    b = *link;
+    if (!fn) {
+        if (b) {
+            *link = b->next;
+            _sf1_free(b->name);
+            _sf1_free(b);
+            __atomic_sub_fetch(&builtin_count, 1, __ATOMIC_RELAXED);
+        }
+    } else if (b) {
+        b->builtin = (_sf1_builtin) { .fn = fn, .ctx = ctx };
+    } else {
+        b = _sf1_malloc(sizeof(*b));
+        if (!b || !(b->name = _sf1_strdup(name))) {
+            _sf1_free(b);
+            pthread_mutex_unlock(&builtins_lock);
+            return _sf1_debug_return(__func__, name, -1);
+        }
+        b->builtin = (_sf1_builtin) { .fn = fn, .ctx = ctx };
+        b->next = builtins;
+        builtins = b;
+        __atomic_add_fetch(&builtin_count, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&builtins_lock);
+    return 0;
+}
+
+/*
+ * Looks up the builtin called name.  Returns 1 and sets *found if there is one.
+ */
+int _sf1_builtin_find(const char *name, _sf1_builtin *found) {
+    int ret = 0;
+
+    if (!__atomic_load_n(&builtin_count, __ATOMIC_RELAXED)) {
+        return 0;
+    }
+    pthread_mutex_lock(&builtins_lock);
+    for (builtin *b = builtins; b; b = b->next) {
+        if (!strcmp(b->name, name)) {
+            *found = b->builtin;
+            ret = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&builtins_lock);
+    return ret;
+}
+
+/*
+ * Must be called with running_lock held.
+ */
+static builtin_run **run_find(pid_t id) {
+    builtin_run **link;
+
+    for (link = &running; *link && ((*link)->id != id); link = &(*link)->next);
+    return link;
+}
+
+static void efd_signal(int efd) {
+    uint64_t one = 1;
+
+    if (write(efd, &one, sizeof(one)) != sizeof(one)) {
+        // Only the counter overflowing fails, and it is readable either way.
+    }
+}
+
+static void *builtin_thread(void *arg) {
+    builtin_run *r = arg;
+    int ret = r->builtin.fn(&r->call);
+
+    close(r->call.in);
+    close(r->call.out);
+    close(r->call.err);
+
+    pthread_mutex_lock(&running_lock);
+    r->stat = r->signaled ? r->signaled : ((ret & 0xff) << 8);
+    __atomic_store_n(&r->done, 1, __ATOMIC_RELEASE);
+    if (r->efd >= 0) {
+        efd_signal(r->efd);
+    }
+    pthread_mutex_unlock(&running_lock);
+    // builtin_kill() leaves it alone once done is set.
+    if (r->cancel >= 0) {
+        close(r->cancel);
+    }
+    return NULL;
+}
+
+/*
+ * Runs builtin in a thread with the files of spawn.  The thread gets its own
+ * copies of the fds, so the caller closes them as it would after a fork.
+ * Returns the id it is reaped with or -1 with errno set.
+ */
+pid_t _sf1_builtin_spawn(const _sf1_builtin *builtin, const _sf1_spawn *spawn) {
+    builtin_run *r = _sf1_calloc(1, sizeof(*r));
+    sigset_t sigpipe, mask;
+    int argc = 0;
+    int err;
+
+    if (!r) {
+        return -1;
+    }
+    while (spawn->argv[argc]) {
+        argc++;
+    }
+    r->builtin = *builtin;
+    r->call = (systemf1_builtin_call) {
+        .argc = argc,
+        .argv = spawn->argv,
+        .envp = spawn->envp,
+        .in = fcntl(spawn->in, F_DUPFD_CLOEXEC, 0),
+        .out = fcntl(spawn->out, F_DUPFD_CLOEXEC, 0),
+        .err = fcntl(spawn->err, F_DUPFD_CLOEXEC, 0),
+        .dirfd = spawn->dirfd,
+        .ctx = builtin->ctx,
+    };
+#ifdef __linux__
+    r->efd = eventfd(0, EFD_CLOEXEC);
+    r->cancel = eventfd(0, EFD_CLOEXEC);
+#else
+    r->efd = -1;
+    r->cancel = -1;
+#endif
+    r->call.cancel = r->cancel;
+    if ((r->call.in < 0) || (r->call.out < 0) || (r->call.err < 0)) {
+        goto exit_error;
+    }
+
+    pthread_mutex_lock(&running_lock);
+    r->id = next_id;
+    next_id = (next_id == 0x7fffffff) ? _SF1_BUILTIN_PID : next_id + 1;
+    r->next = running;
+    running = r;
+    pthread_mutex_unlock(&running_lock);
+
+    // A write to a pipe nobody reads fails with EPIPE rather than raising a
+    // SIGPIPE that would kill the caller.  The thread starts with it blocked.
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, &mask);
+    err = pthread_create(&r->thread, NULL, builtin_thread, r);
+    pthread_sigmask(SIG_SETMASK, &mask, NULL);
+    if (!err) {
+        return r->id;
+    }
+
+    pthread_mutex_lock(&running_lock);
+    *run_find(r->id) = r->next;
+    pthread_mutex_unlock(&running_lock);
+    errno = err;
+
+exit_error:
+    err = errno;
+    if (r->call.in >= 0) {
+        close(r->call.in);
+    }
+    if (r->call.out >= 0) {
+        close(r->call.out);
+    }
+    if (r->call.err >= 0) {
+        close(r->call.err);
+    }
+    if (r->efd >= 0) {
+        close(r->efd);
+    }
+    if (r->cancel >= 0) {
+        close(r->cancel);
+    }
+    _sf1_free(r);
+    errno = err;
+    return -1;
+}
+
+/*
+ * waitpid() for a builtin.  With WNOHANG, returns 0 while it is running.
+ */
+pid_t _sf1_builtin_wait(pid_t id, int *stat, int options) {
+    builtin_run **link;
+    builtin_run *r;
+
+    pthread_mutex_lock(&running_lock);
+    link = run_find(id);
+    r = *link;
+    if (!r) {
+        pthread_mutex_unlock(&running_lock);
+        errno = ECHILD;
+        return -1;
+    }
+    if ((options & WNOHANG) && !__atomic_load_n(&r->done, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_unlock(&running_lock);
+        return 0;
+    }
+    *link = r->next;
+    pthread_mutex_unlock(&running_lock);
+
+    pthread_join(r->thread, NULL);
+    if (stat) {
+        *stat = r->stat;
+    }
+    if (r->efd >= 0) {
+        close(r->efd);
+    }
+    _sf1_free(r);
+    return id;
+}
+
+/*
+ * kill() for a builtin.  The thread can't be interrupted, so sig only becomes
+ * its status once it returns.  fn can see it was sent one on call.cancel.
+ */
+static int builtin_kill(pid_t id, int sig) {
+    builtin_run *r;
+
+    pthread_mutex_lock(&running_lock);
+    r = *run_find(id);
+    if (r && !r->done && sig && !r->signaled) {
+        r->signaled = sig;
+        if (r->cancel >= 0) {
+            efd_signal(r->cancel);
+        }
+    }
+    pthread_mutex_unlock(&running_lock);
+    if (!r) {
+        errno = ESRCH;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * kill() for any pid of a pid_chain.
+ */
+int _sf1_kill(pid_t pid, int sig) {
+    return _sf1_builtin_is(pid) ? builtin_kill(pid, sig) : kill(pid, sig);
+}
+
+/*
+ * Returns an fd that is readable once the builtin has returned, like a pidfd.
+ * It must be closed.  Returns -1 on failure.
+ */
+int _sf1_builtin_fd(pid_t id) {
+    builtin_run *r;
+    int fd = -1;
+
+    pthread_mutex_lock(&running_lock);
+    r = *run_find(id);
+    if (!r || (r->efd < 0)) {
+        errno = r ? ENOSYS : ESRCH;
+    } else {
+        fd = fcntl(r->efd, F_DUPFD_CLOEXEC, 0);
+    }
+    pthread_mutex_unlock(&running_lock);
+    return fd;
+}
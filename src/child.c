@@ -0,0 +1,206 @@
+#define _GNU_SOURCE // sched_setaffinity() and cpu_set_t.
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#ifdef __linux__
+#include <linux/sched.h>
+#include <linux/ioprio.h>
+#endif
+
+#include "systemf-internal.h"
+
+#if defined(SYS_clone3) && defined(CLONE_INTO_CGROUP)
+#define HAVE_CLONE_INTO_CGROUP 1
+#endif
+
+#ifndef IOPRIO_WHO_PROCESS
+#define IOPRIO_WHO_PROCESS 1
+#endif
+
+/*
+ * Set once clone3() turns out not to know CLONE_INTO_CGROUP.  Races only cost
+ * an extra failed clone3().
+ */
+static int clone_into_cgroup_missing = 0;
+
+/*
+ * Checks the limits opts put on the children and opens the cgroup they start
+ * in.  *cgroup_fd is -1 when there is no cgroup, otherwise it must be closed
+ * once the run is done.  Returns -1 on failure.
+ */
+int _sf1_child_prepare(const systemf1_opts *opts, int *cgroup_fd) {
+    *cgroup_fd = -1;
+    if (!opts) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < opts->rlimit_count; i++) {
+        if (opts->rlimits[i].cur > opts->rlimits[i].max) {
+            fprintf(stderr, "systemf: %s: rlimit %d\n", strerror(EINVAL), opts->rlimits[i].resource);
+            return -1;
+        }
+    }
+    if (opts->cpu_affinity && !opts->cpu_affinity_size) {
+        fprintf(stderr, "systemf: %s: cpu_affinity_size\n", strerror(EINVAL));
+        return -1;
+    }
+
+    if (opts->cgroup) {
+        *cgroup_fd = open(opts->cgroup, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (*cgroup_fd < 0) {
+            fprintf(stderr, "systemf: %s: cgroup %s\n", strerror(errno), opts->cgroup);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * fork() that starts the child in the cgroup at cgroup_fd when there is one.
+ * *in_cgroup is set when the child was started there.  Otherwise the child has
+ * to call _sf1_child_join_cgroup() itself.
+ */
+pid_t _sf1_child_fork(int cgroup_fd, int *in_cgroup) {
+    *in_cgroup = 0;
+#ifdef HAVE_CLONE_INTO_CGROUP
+    if ((cgroup_fd >= 0) && !__atomic_load_n(&clone_into_cgroup_missing, __ATOMIC_RELAXED)) {
+        struct clone_args args = {
+            .flags = CLONE_INTO_CGROUP,
+            .exit_signal = SIGCHLD,
+            .cgroup = cgroup_fd,
+        };
+        long pid = syscall(SYS_clone3, &args, sizeof(args));
+
+        if (pid >= 0) {
+            *in_cgroup = 1;
+            return pid;
+        }
+        // ENOSYS is before 5.3 and E2BIG is before CLONE_INTO_CGROUP in 5.7.
+        if ((errno != ENOSYS) && (errno != E2BIG)) {
+            return -1;
+        }
+        __atomic_store_n(&clone_into_cgroup_missing, 1, __ATOMIC_RELAXED);
+    }
+#endif
+    return fork();
+}
+
+/*
+ * Moves the calling child into the cgroup at cgroup_fd before it execs.
+ */
+int _sf1_child_join_cgroup(int cgroup_fd) {
+    int fd = openat(cgroup_fd, "cgroup.procs", O_WRONLY | O_CLOEXEC);
+    int ret;
+
+    if (fd < 0) {
+        return -1;
+    }
+    // "0" is the writer.
+    ret = (write(fd, "0", 1) == 1) ? 0 : -1;
+    close(fd);
+    return ret;
+}
+
+/*
+ * Applies the limits in opts to the calling child.  Only calls that are safe
+ * between fork() and exec() are used.  Returns -1 on failure.
+ */
+int _sf1_child_limit(const systemf1_opts *opts) {
+    if (!opts) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < opts->rlimit_count; i++) {
+        struct rlimit rlim = {
+            .rlim_cur = opts->rlimits[i].cur,
+            .rlim_max = opts->rlimits[i].max,
+        };
+        if (setrlimit(opts->rlimits[i].resource, &rlim)) {
+            return -1;
+        }
+    }
+
+    if (opts->nice) {
+        // nice() can return -1 on success.
+        errno = 0;
+        if ((nice(opts->nice) == -1) && errno) {
+            return -1;
+        }
+    }
+
+    if (opts->ioprio) {
+#ifdef SYS_ioprio_set
+        if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, opts->ioprio)) {
+            return -1;
+        }
+#else
+        errno = ENOSYS;
+        return -1;
+#endif
+    }
+
+    if (opts->cpu_affinity) {
+#ifdef __linux__
+        if (sched_setaffinity(0, opts->cpu_affinity_size, opts->cpu_affinity)) {
+            return -1;
+        }
+#else
+        errno = ENOSYS;
+        return -1;
+#endif
+    }
+
+    return 0;
+}
+
+/*
+ * Forks a child that runs spawn->argv.  Backs off and tries again when the
+ * process limit is hit and gives up after about an eighth of a second.
+ * Returns the pid or -1.  The child never returns.
+ */
+pid_t _sf1_child_spawn(const _sf1_spawn *spawn) {
+    struct timespec backoff = { .tv_sec = 0, .tv_nsec = 1000000 };
+    int in_cgroup;
+    pid_t pid;
+
+    for (int attempt = 1; ((pid = _sf1_child_fork(spawn->cgroup_fd, &in_cgroup)) < 0) &&
+             (errno == EAGAIN) && (attempt < 8); attempt++) {
+        nanosleep(&backoff, NULL);
+        backoff.tv_nsec *= 2;
+    }
+    if (pid != 0) {
+        return pid;
+    }
+
+    if ((spawn->cgroup_fd >= 0) && !in_cgroup && _sf1_child_join_cgroup(spawn->cgroup_fd)) {
+        kill(getpid(), SIGKILL);
+    }
+    if ((spawn->dirfd != AT_FDCWD) && fchdir(spawn->dirfd)) {
+        kill(getpid(), SIGKILL);
+    }
+    dup2(spawn->in, 0);
+    dup2(spawn->out, 1);
+    dup2(spawn->err, 2);
+    _sf1_close_upper_fd();
+
+    // After closing so a lower RLIMIT_NOFILE doesn't leave fds open.
+    if (_sf1_child_limit(spawn->limits)) {
+        kill(getpid(), SIGKILL);
+    }
+
+    _SF1_PROBE(exec, spawn->argv[0]);
+    execve(spawn->argv[0], spawn->argv, spawn->envp);
+
+    // If execv exits, we don't have an easy way to send the results back other
+    // than some extra socket.  Instead we should try catching all exceptions
+    // (file not found, file not executable) before forking.  Kill thyself.
+    kill(getpid(), SIGKILL);
+    return -1;
+}
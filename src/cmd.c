@@ -0,0 +1,198 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "systemf-internal.h"
+
+/*
+ * A chain of tasks built without a fmt.  last is where arguments and
+ * redirects are added.
+ */
+struct systemf1_cmd_ {
+    _sf1_task *tasks;
+    _sf1_task *last;
+};
+
+static _sf1_redirect *new_redirect(_sf1_stream stream, _sf1_stream target) {
+    _sf1_redirect *redirect = _sf1_calloc(1, sizeof(*redirect));
+
+    if (redirect) {
+        redirect->stream = stream;
+        redirect->target = target;
+    }
+    return redirect;
+}
+
+static void append_redirect(_sf1_task *task, _sf1_redirect *redirect) {
+    _sf1_redirect **next_pp = &(task->redirects);
+    while (*next_pp) {
+        next_pp = &((*next_pp)->next);
+    }
+    *next_pp = redirect;
+}
+
+/*
+ * Moves the tasks of right to the end of left and frees right.
+ */
+static int join(systemf1_cmd *left, systemf1_cmd *right, _sf1_run_if run_if) {
+    right->tasks->run_if = run_if;
+    left->last->next = right->tasks;
+    left->last = right->last;
+    _sf1_free(right);
+    return 0;
+}
+
+systemf1_cmd *systemf1_cmd_new(const char *path) {
+    systemf1_cmd *cmd;
+
+    if (!path) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    cmd = _sf1_calloc(1, sizeof(*cmd));
+    if (!cmd) {
+        return NULL;
+    }
+    cmd->tasks = cmd->last = _sf1_task_create();
+    if (!cmd->tasks || systemf1_cmd_arg(cmd, path, 0)) {
+        systemf1_cmd_free(cmd);
+        return NULL;
+    }
+    return cmd;
+}
+
+int systemf1_cmd_arg(systemf1_cmd *cmd, const char *arg, int flags) {
+    char *text;
+    char *trusted_path = NULL;
+
+    if (!cmd || !arg) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    text = _sf1_strdup(arg);
+    if (text && (flags & SYSTEMF1_ARG_SANDBOX)) {
+        // The whole argument is untrusted so it is sandboxed to the current directory.
+        trusted_path = _sf1_strdup("");
+    }
+    if (!text || ((flags & SYSTEMF1_ARG_SANDBOX) && !trusted_path) ||
+        !_sf1_task_add_arg(cmd->last, text, trusted_path, (flags & SYSTEMF1_ARG_GLOB) != 0)) {
+        _sf1_free(text);
+        _sf1_free(trusted_path);
+        return -1;
+    }
+    return 0;
+}
+
+int systemf1_cmd_glob(systemf1_cmd *cmd, const char *pattern, int flags) {
+    return systemf1_cmd_arg(cmd, pattern, flags | SYSTEMF1_ARG_GLOB);
+}
+
+int systemf1_cmd_redirect(systemf1_cmd *cmd, int stream, const char *path, int flags) {
+    static const _sf1_stream streams[] = { _SF1_STDIN, _SF1_STDOUT, _SF1_STDERR };
+    _sf1_redirect *redirect;
+
+    // stdin can only come from a file.
+    if (!cmd || (stream < 0) || (stream > 2) || (!path && (stream == 0))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    redirect = new_redirect(streams[stream], path ? _SF1_FILE : _SF1_SHARE);
+    if (!redirect) {
+        return -1;
+    }
+    redirect->append = (flags & SYSTEMF1_REDIRECT_APPEND) != 0;
+    if (path) {
+        redirect->text = _sf1_strdup(path);
+        if (!redirect->text) {
+            _sf1_free(redirect);
+            return -1;
+        }
+    }
+    append_redirect(cmd->last, redirect);
+    return 0;
+}
+
+int systemf1_cmd_redirect_fd(systemf1_cmd *cmd, int stream, int fd) {
+    static const _sf1_stream streams[] = { _SF1_STDIN, _SF1_STDOUT, _SF1_STDERR };
+    _sf1_redirect *redirect;
+
+    if (!cmd || (stream < 0) || (stream > 2) || (fd < 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    redirect = new_redirect(streams[stream], _SF1_FD);
+    if (!redirect) {
+        return -1;
+    }
+    redirect->fd = fd;
+    append_redirect(cmd->last, redirect);
+    return 0;
+}
+
+int systemf1_cmd_pipe_to(systemf1_cmd *left, systemf1_cmd *right) {
+    _sf1_redirect *out, *in;
+
+    if (!left || !right || (left == right)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    out = new_redirect(_SF1_STDOUT, _SF1_PIPE);
+    in = new_redirect(_SF1_STDIN, _SF1_PIPE);
+    if (!out || !in) {
+        _sf1_free(out);
+        _sf1_free(in);
+        return -1;
+    }
+    append_redirect(left->last, out);
+    append_redirect(right->tasks, in);
+    return join(left, right, _SF1_RUN_ALWAYS);
+}
+
+int systemf1_cmd_and_then(systemf1_cmd *left, systemf1_cmd *right) {
+    if (!left || !right || (left == right)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return join(left, right, _SF1_RUN_IF_PREV_SUCCEEDED);
+}
+
+int systemf1_cmd_or_else(systemf1_cmd *left, systemf1_cmd *right) {
+    if (!left || !right || (left == right)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return join(left, right, _SF1_RUN_IF_PREV_FAILED);
+}
+
+int systemf1_cmd_then(systemf1_cmd *left, systemf1_cmd *right) {
+    if (!left || !right || (left == right)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return join(left, right, _SF1_RUN_ALWAYS);
+}
+
+int systemf1_cmd_run(systemf1_cmd *cmd) {
+    return systemf1_cmd_run_ex(cmd, NULL);
+}
+
+int systemf1_cmd_run_ex(systemf1_cmd *cmd, const systemf1_opts *opts) {
+    if (!cmd) {
+        errno = EINVAL;
+        return _sf1_debug_return(__func__, NULL, -1);
+    }
+    return _sf1_debug_return(__func__, cmd->tasks->args ? cmd->tasks->args->text : NULL,
+                             _sf1_tasks_run(cmd->tasks, opts, _sf1_call_begin()));
+}
+
+void systemf1_cmd_free(systemf1_cmd *cmd) {
+    if (cmd) {
+        _sf1_task_free(cmd->tasks);
+        _sf1_free(cmd);
+    }
+}
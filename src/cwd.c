@@ -0,0 +1,98 @@
+#define _GNU_SOURCE // O_PATH and the glob_t directory functions.
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <glob.h>
+#include <sys/stat.h>
+
+#include "systemf-internal.h"
+
+/*
+ * Returns the directory the children of a run with opts start in.  That is
+ * AT_FDCWD when opts don't name one.  *owned is set when the fd was opened
+ * here and must be closed once the run is done.  Returns -1 on failure.
+ */
+int _sf1_cwd_open(const systemf1_opts *opts, int *owned) {
+    int base = (opts && (opts->cwd_fd > 0)) ? opts->cwd_fd : AT_FDCWD;
+    struct stat st;
+    int fd;
+
+    *owned = 0;
+    if (!opts || (!opts->cwd && (base == AT_FDCWD))) {
+        return AT_FDCWD;
+    }
+
+    if (opts->cwd) {
+        fd = openat(base, opts->cwd, O_PATH | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            fprintf(stderr, "systemf: %s: %s\n", strerror(errno), opts->cwd);
+            return -1;
+        }
+        *owned = 1;
+        return fd;
+    }
+
+    if (fstat(base, &st) == 0) {
+        if (S_ISDIR(st.st_mode)) {
+            return base;
+        }
+        errno = ENOTDIR;
+    }
+    fprintf(stderr, "systemf: %s: cwd_fd %d\n", strerror(errno), base);
+    return -1;
+}
+
+/*
+ * glob() has no way to pass the directory to its callbacks.
+ */
+static __thread int glob_dirfd;
+
+static void *glob_opendir(const char *path) {
+    int fd = openat(glob_dirfd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    DIR *dir;
+
+    if (fd < 0) {
+        return NULL;
+    }
+    dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+    }
+    return dir;
+}
+
+static struct dirent *glob_readdir(void *dir) {
+    return readdir(dir);
+}
+
+static void glob_closedir(void *dir) {
+    closedir(dir);
+}
+
+static int glob_lstat(const char *path, struct stat *st) {
+    return fstatat(glob_dirfd, path, st, AT_SYMLINK_NOFOLLOW);
+}
+
+static int glob_stat(const char *path, struct stat *st) {
+    return fstatat(glob_dirfd, path, st, 0);
+}
+
+/*
+ * glob() with relative patterns resolved from dirfd.
+ */
+int _sf1_glob_at(int dirfd, const char *pattern, glob_t *pglob) {
+    if (dirfd == AT_FDCWD) {
+        return glob(pattern, 0, NULL, pglob);
+    }
+
+    glob_dirfd = dirfd;
+    pglob->gl_opendir = glob_opendir;
+    pglob->gl_readdir = glob_readdir;
+    pglob->gl_closedir = glob_closedir;
+    pglob->gl_lstat = glob_lstat;
+    pglob->gl_stat = glob_stat;
+    return glob(pattern, GLOB_ALTDIRFUNC, NULL, pglob);
+}
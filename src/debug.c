@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#include "systemf-internal.h"
+
+/*
+ * Read on every call, so tracing costs a relaxed load while it is off.
+ */
+int _sf1_debug_flags = 0;
+static FILE *debug_file = NULL; // NULL is stderr.
+
+int systemf1_debug_set(int flags) {
+    return __atomic_exchange_n(&_sf1_debug_flags, flags, __ATOMIC_RELAXED);
+}
+
+int systemf1_debug_get() {
+    return __atomic_load_n(&_sf1_debug_flags, __ATOMIC_RELAXED);
+}
+
+/*
+ * Returns the previous file.  A NULL file goes back to stderr.
+ */
+FILE *systemf1_debug_file_set(FILE *file) {
+    FILE *prev = __atomic_exchange_n(&debug_file, file, __ATOMIC_ACQ_REL);
+    return prev ? prev : stderr;
+}
+
+FILE *systemf1_debug_file_get() {
+    FILE *file = __atomic_load_n(&debug_file, __ATOMIC_ACQUIRE);
+    return file ? file : stderr;
+}
+
+unsigned long long _sf1_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Prints s so it could be pasted into a shell.
+ */
+static void print_word(FILE *file, const char *s) {
+    if (*s && (strspn(s, "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_-+=.,/:@%") == strlen(s))) {
+        fputs(s, file);
+        return;
+    }
+    fputc('\'', file);
+    for (; *s; s++) {
+        if (*s == '\'') {
+            fputs("'\\''", file);
+        } else {
+            fputc(*s, file);
+        }
+    }
+    fputc('\'', file);
+}
+
+static void print_redirect(FILE *file, const _sf1_redirect *redirect) {
+    static const char *const prefixes[] = {
+        [_SF1_STDIN] = "<", [_SF1_STDOUT] = ">", [_SF1_STDERR] = "2>",
+    };
+
+    if (redirect->target == _SF1_PIPE) {
+        // Pipes show up between the commands.
+        return;
+    }
+    fprintf(file, " %s", prefixes[redirect->stream]);
+    switch (redirect->target) {
+        case _SF1_FILE:
+            if (redirect->append) {
+                fputc('>', file);
+            }
+            print_word(file, redirect->text);
+            break;
+        case _SF1_SHARE:
+            fputs((redirect->stream == _SF1_STDOUT) ? "&2" : "&1", file);
+            break;
+        case _SF1_FD:
+            fprintf(file, "&%d", redirect->fd);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * SYSTEMF1_DBG_EXEC: prints the argv and redirects task was launched with as pid.
+ */
+void _sf1_debug_exec(const _sf1_task *task, pid_t pid) {
+    FILE *file = systemf1_debug_file_get();
+    int piped = 0;
+
+    flockfile(file);
+    fprintf(file, "systemf: exec %d:", (int) pid);
+    for (char **argv = task->argv; *argv; argv++) {
+        fputc(' ', file);
+        print_word(file, *argv);
+    }
+    for (const _sf1_redirect *r = task->redirects; r; r = r->next) {
+        print_redirect(file, r);
+        if ((r->stream == _SF1_STDOUT) && (r->target == _SF1_PIPE)) {
+            piped = 1;
+        }
+    }
+    fputs(piped ? " |\n" : "\n", file);
+    fflush(file);
+    funlockfile(file);
+}
+
+/*
+ * SYSTEMF1_DBG_EXEC: prints how the group launched at launched_ns ended.
+ */
+void _sf1_debug_exit(pid_t pid, int stat, unsigned long long launched_ns) {
+    FILE *file = systemf1_debug_file_get();
+    double ms = (_sf1_now_ns() - launched_ns) / 1e6;
+
+    if (WIFSIGNALED(stat)) {
+        fprintf(file, "systemf: exit %d: signal %s after %.3f ms\n", (int) pid, strsignal(WTERMSIG(stat)), ms);
+    } else {
+        fprintf(file, "systemf: exit %d: %d after %.3f ms\n", (int) pid, WEXITSTATUS(stat), ms);
+    }
+    fflush(file);
+}
+
+/*
+ * SYSTEMF1_DBG_ERRORS: prints a nonzero ret of func for what.  Returns ret.
+ */
+int _sf1_debug_return(const char *func, const char *what, int ret) {
+    if (ret && _sf1_debugging(SYSTEMF1_DBG_ERRORS)) {
+        FILE *file = systemf1_debug_file_get();
+
+        fprintf(file, "systemf: %s returned %d: %s\n", func, ret, what ? what : "");
+        fflush(file);
+    }
+    return ret;
+}
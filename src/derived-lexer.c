@@ -561,8 +561,8 @@ static void yynoreturn yy_fatal_error ( const char* msg , yyscan_t yyscanner );
 	yyg->yy_hold_char = *yy_cp; \
 	*yy_cp = '\0'; \
 	yyg->yy_c_buf_p = yy_cp;
-#define YY_NUM_RULES 24
-#define YY_END_OF_BUFFER 25
+#define YY_NUM_RULES 29
+#define YY_END_OF_BUFFER 30
 /* This struct is not used in this scanner,
    but its presence is necessary. */
 struct yy_trans_info
@@ -570,14 +570,15 @@ struct yy_trans_info
 	flex_int32_t yy_verify;
 	flex_int32_t yy_nxt;
 	};
-static const flex_int16_t yy_accept[56] =
+static const flex_int16_t yy_accept[65] =
     {   0,
-        0,    0,   25,   23,    9,   23,   23,    3,    1,    1,
-       22,   10,   14,   23,   20,    9,    0,    0,   22,   10,
-       14,   20,    0,    0,    8,    5,    4,   19,   13,    1,
-       12,   22,   10,   14,    0,   18,    0,   20,   21,    6,
-        7,   19,   13,   17,   12,    0,   16,   15,   18,    2,
-       21,   17,   11,   16,    0
+        0,    0,   30,   28,   12,   28,   28,   28,    3,    1,
+        1,   27,   13,   17,   28,   23,   12,    0,    0,   27,
+       13,   17,   23,    0,    0,    0,    9,    8,    5,    4,
+       22,   16,    1,   15,   27,   13,   17,    0,   21,    0,
+       23,   24,   26,    6,    7,   11,   10,   22,   16,   20,
+       15,    0,   19,   18,   21,    2,   24,   25,   26,   20,
+       14,   19,   25,    0
     } ;
 
 static const YY_CHAR yy_ec[256] =
@@ -588,14 +589,14 @@ static const YY_CHAR yy_ec[256] =
         1,    2,    4,    1,    1,    1,    5,    6,    1,    1,
         1,    7,    1,    1,    8,    8,    8,    8,    9,   10,
         8,    8,    8,    8,    8,    8,    8,    1,   11,   12,
-        1,   13,   14,    1,    8,    8,    8,    8,    8,    8,
+        1,   13,   14,   15,    8,    8,    8,    8,    8,   16,
         8,    8,    8,    8,    8,    8,    8,    8,    8,    8,
         8,    8,    8,    8,    8,    8,    8,    8,    8,    8,
-       15,    1,   16,    1,    8,    1,    8,    8,    8,   17,
+       17,    1,   18,    1,    8,    1,    8,    8,    8,   19,
 
         8,    8,    8,    8,    8,    8,    8,    8,    8,    8,
-        8,   18,    8,    8,   19,    8,    8,    8,    8,    8,
-        8,    8,    1,   20,    1,    1,    1,    1,    1,    1,
+        8,   20,    8,    8,   21,    8,    8,    8,    8,    8,
+        8,    8,    1,   22,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
@@ -612,60 +613,365 @@ static const YY_CHAR yy_ec[256] =
         1,    1,    1,    1,    1
     } ;
 
-static const YY_CHAR yy_meta[21] =
+static const YY_CHAR yy_meta[23] =
     {   0,
-        1,    1,    1,    1,    1,    1,    1,    2,    2,    2,
-        1,    1,    1,    1,    1,    1,    2,    2,    2,    1
+        1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
+        1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
+        1,    1
     } ;
 
-static const flex_int16_t yy_base[58] =
+static const flex_int16_t yy_base[65] =
     {   0,
-        0,    0,   78,   79,   19,   36,   20,   79,    0,   64,
-       74,   73,   21,    0,   22,    0,   22,   61,   71,   70,
-        0,   36,   53,   52,   79,   79,   79,   67,   34,    0,
-       35,   66,   65,   64,   55,   62,   47,   60,   59,   79,
-       79,   58,   57,   56,   55,   43,   49,   79,   48,   79,
-       47,   44,   79,   43,   79,   42,   20
+        1,   24,   47,   70,   93,  116,  139,  162,  185,  208,
+      231,  254,  277,  300,  323,  346,  369,  392,  415,  438,
+      461,  484,  507,  530,  553,  576,  599,  622,  645,  668,
+      691,  714,  737,  760,  783,  806,  829,  852,  875,  898,
+      921,  944,  967,  990, 1013, 1036, 1059, 1082, 1105, 1128,
+     1151, 1174, 1197, 1220, 1243, 1266, 1289, 1312, 1335, 1358,
+     1381, 1404, 1427, 1450
     } ;
 
-static const flex_int16_t yy_def[58] =
+static const flex_int16_t yy_def[65] =
     {   0,
-       55,    1,   55,   55,   55,   55,   55,   55,   56,   56,
-       55,   55,   55,   57,   55,    5,   55,   55,   55,   55,
-       13,   55,   55,   55,   55,   55,   55,   55,   55,   56,
-       55,   55,   55,   55,   55,   55,   57,   55,   55,   55,
-       55,   55,   55,   55,   55,   55,   55,   55,   55,   55,
-       55,   55,   55,   55,    0,   55,   55
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,    0
     } ;
 
-static const flex_int16_t yy_nxt[100] =
+static const flex_int16_t yy_nxt[1473] =
     {   0,
-        4,    5,    4,    4,    6,    7,    8,    9,    9,   10,
-       11,   12,   13,    8,   14,    4,    9,    9,    9,   15,
-       16,   37,   34,   38,   17,   28,   35,   28,   18,   19,
-       20,   21,   29,   36,   29,   43,   45,   38,   22,   23,
-       46,   39,   24,   30,   54,   52,   44,   47,   51,   49,
-       54,   53,   25,   26,   27,   39,   45,   52,   43,   42,
-       51,   38,   50,   49,   48,   34,   33,   32,   42,   41,
-       40,   33,   32,   31,   33,   32,   31,   55,    3,   55,
-       55,   55,   55,   55,   55,   55,   55,   55,   55,   55,
-       55,   55,   55,   55,   55,   55,   55,   55,   55
-
+        3,    4,    5,    6,    4,    7,    8,    9,   10,   10,
+       11,   12,   13,   14,    9,    4,   10,   15,    4,   10,
+       10,   10,   16,    3,    4,    5,    6,    4,    7,    8,
+        9,   10,   10,   11,   12,   13,   14,    9,    4,   10,
+       15,    4,   10,   10,   10,   16,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,    3,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,    3,   64,   17,   64,   64,   64,   18,   64,
+
+       64,   64,   19,   20,   21,   22,   64,   64,   64,   64,
+       64,   64,   64,   64,   23,    3,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,    3,   64,
+       64,   64,   24,   64,   64,   25,   64,   64,   64,   64,
+       64,   64,   64,   26,   27,   64,   64,   28,   29,   30,
+       64,    3,   64,   64,   64,   64,   64,   31,   64,   64,
+       64,   64,   64,   64,   32,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,    3,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+
+       64,   64,   64,   64,   64,   64,   64,    3,   64,   64,
+       64,   64,   64,   64,   64,   33,   33,   33,   64,   64,
+       64,   64,   64,   33,   64,   64,   33,   33,   33,   64,
+        3,   64,   64,   64,   64,   64,   64,   64,   33,   33,
+       33,   64,   64,   34,   64,   64,   33,   64,   64,   33,
+       33,   33,   64,    3,   64,   35,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,    3,   64,   36,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,    3,
+
+       64,   37,   64,   64,   64,   38,   64,   64,   64,   64,
+       64,   64,   39,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,    3,   64,   64,   64,   64,   64,   64,   64,
+       40,   40,   40,   64,   64,   64,   64,   64,   40,   64,
+       64,   40,   40,   40,   64,    3,   64,   41,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   42,   64,
+       64,   64,   64,   64,   64,   64,   64,   43,    3,   64,
+       17,   64,   64,   64,   18,   64,   64,   64,   19,   20,
+       21,   22,   64,   64,   64,   64,   64,   64,   64,   64,
+       23,    3,   64,   64,   64,   64,   64,   31,   64,   64,
+
+       64,   64,   64,   64,   32,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,    3,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   34,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,    3,   64,   35,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+        3,   64,   36,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,    3,   64,   37,   64,   64,   64,   38,
+       64,   64,   64,   64,   64,   64,   39,   64,   64,   64,
+
+       64,   64,   64,   64,   64,   64,    3,   64,   41,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   42,
+       64,   64,   64,   64,   64,   64,   64,   64,   43,    3,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   44,
+       64,   64,    3,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   45,   64,   64,    3,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   46,   47,   64,    3,   64,
+
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,    3,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,    3,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,    3,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+        3,   64,   48,   64,   64,   64,   64,   64,   64,   64,
+
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,    3,   64,   49,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   50,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,    3,   64,   64,   64,
+       64,   64,   64,   64,   33,   33,   33,   64,   64,   64,
+       64,   64,   33,   64,   64,   33,   33,   33,   64,    3,
+       64,   51,   64,   64,   64,   52,   64,   64,   64,   64,
+       64,   64,   53,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,    3,   64,   35,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+
+       64,   64,   64,   64,   64,    3,   64,   36,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,    3,   64,
+       37,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,    3,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   54,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,    3,   64,   55,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,    3,   64,   64,
+
+       64,   64,   64,   64,   64,   40,   40,   40,   64,   64,
+       64,   64,   64,   40,   64,   56,   40,   40,   40,   64,
+        3,   64,   41,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,    3,   64,   57,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   58,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,    3,   64,   59,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,    3,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,    3,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,    3,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,    3,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,    3,   64,   48,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+
+       64,   64,   64,   64,    3,   64,   49,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,    3,   64,   60,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+        3,   64,   51,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,    3,   64,   64,   64,   64,   64,   64,
+       64,   64,   61,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,    3,   64,   62,   64,
+
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,    3,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,    3,   64,   55,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,    3,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,    3,   64,
+       57,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,    3,   64,   63,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,    3,   64,   59,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,    3,   64,   60,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+        3,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+
+       64,   64,   64,    3,   64,   62,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,    3,   64,   63,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,    3,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64
     } ;
 
-static const flex_int16_t yy_chk[100] =
+static const flex_int16_t yy_chk[1473] =
     {   0,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
-        5,   57,   13,   15,    5,    7,   13,   17,    5,    5,
-        5,    5,    7,   13,   17,   29,   31,   22,    5,    6,
-       31,   15,    6,   56,   54,   52,   29,   31,   51,   49,
-       47,   46,    6,    6,    6,   22,   45,   44,   43,   42,
-       39,   38,   37,   36,   35,   34,   33,   32,   28,   24,
-       23,   20,   19,   18,   12,   11,   10,    3,   55,   55,
+        1,    1,    1,    2,    2,    2,    2,    2,    2,    2,
+        2,    2,    2,    2,    2,    2,    2,    2,    2,    2,
+        2,    2,    2,    2,    2,    2,    3,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,    3,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,    3,    3,    3,    4,
+        4,    4,    4,    4,    4,    4,    4,    4,    4,    4,
+        4,    4,    4,    4,    4,    4,    4,    4,    4,    4,
+        4,    4,    5,    5,    5,    5,    5,    5,    5,    5,
+
+        5,    5,    5,    5,    5,    5,    5,    5,    5,    5,
+        5,    5,    5,    5,    5,    6,    6,    6,    6,    6,
+        6,    6,    6,    6,    6,    6,    6,    6,    6,    6,
+        6,    6,    6,    6,    6,    6,    6,    6,    7,    7,
+        7,    7,    7,    7,    7,    7,    7,    7,    7,    7,
+        7,    7,    7,    7,    7,    7,    7,    7,    7,    7,
+        7,    8,    8,    8,    8,    8,    8,    8,    8,    8,
+        8,    8,    8,    8,    8,    8,    8,    8,    8,    8,
+        8,    8,    8,    8,    9,    9,    9,    9,    9,    9,
+        9,    9,    9,    9,    9,    9,    9,    9,    9,    9,
+
+        9,    9,    9,    9,    9,    9,    9,   10,   10,   10,
+       10,   10,   10,   10,   10,   10,   10,   10,   10,   10,
+       10,   10,   10,   10,   10,   10,   10,   10,   10,   10,
+       11,   11,   11,   11,   11,   11,   11,   11,   11,   11,
+       11,   11,   11,   11,   11,   11,   11,   11,   11,   11,
+       11,   11,   11,   12,   12,   12,   12,   12,   12,   12,
+       12,   12,   12,   12,   12,   12,   12,   12,   12,   12,
+       12,   12,   12,   12,   12,   12,   13,   13,   13,   13,
+       13,   13,   13,   13,   13,   13,   13,   13,   13,   13,
+       13,   13,   13,   13,   13,   13,   13,   13,   13,   14,
+
+       14,   14,   14,   14,   14,   14,   14,   14,   14,   14,
+       14,   14,   14,   14,   14,   14,   14,   14,   14,   14,
+       14,   14,   15,   15,   15,   15,   15,   15,   15,   15,
+       15,   15,   15,   15,   15,   15,   15,   15,   15,   15,
+       15,   15,   15,   15,   15,   16,   16,   16,   16,   16,
+       16,   16,   16,   16,   16,   16,   16,   16,   16,   16,
+       16,   16,   16,   16,   16,   16,   16,   16,   17,   17,
+       17,   17,   17,   17,   17,   17,   17,   17,   17,   17,
+       17,   17,   17,   17,   17,   17,   17,   17,   17,   17,
+       17,   18,   18,   18,   18,   18,   18,   18,   18,   18,
+
+       18,   18,   18,   18,   18,   18,   18,   18,   18,   18,
+       18,   18,   18,   18,   19,   19,   19,   19,   19,   19,
+       19,   19,   19,   19,   19,   19,   19,   19,   19,   19,
+       19,   19,   19,   19,   19,   19,   19,   20,   20,   20,
+       20,   20,   20,   20,   20,   20,   20,   20,   20,   20,
+       20,   20,   20,   20,   20,   20,   20,   20,   20,   20,
+       21,   21,   21,   21,   21,   21,   21,   21,   21,   21,
+       21,   21,   21,   21,   21,   21,   21,   21,   21,   21,
+       21,   21,   21,   22,   22,   22,   22,   22,   22,   22,
+       22,   22,   22,   22,   22,   22,   22,   22,   22,   22,
+
+       22,   22,   22,   22,   22,   22,   23,   23,   23,   23,
+       23,   23,   23,   23,   23,   23,   23,   23,   23,   23,
+       23,   23,   23,   23,   23,   23,   23,   23,   23,   24,
+       24,   24,   24,   24,   24,   24,   24,   24,   24,   24,
+       24,   24,   24,   24,   24,   24,   24,   24,   24,   24,
+       24,   24,   25,   25,   25,   25,   25,   25,   25,   25,
+       25,   25,   25,   25,   25,   25,   25,   25,   25,   25,
+       25,   25,   25,   25,   25,   26,   26,   26,   26,   26,
+       26,   26,   26,   26,   26,   26,   26,   26,   26,   26,
+       26,   26,   26,   26,   26,   26,   26,   26,   27,   27,
+
+       27,   27,   27,   27,   27,   27,   27,   27,   27,   27,
+       27,   27,   27,   27,   27,   27,   27,   27,   27,   27,
+       27,   28,   28,   28,   28,   28,   28,   28,   28,   28,
+       28,   28,   28,   28,   28,   28,   28,   28,   28,   28,
+       28,   28,   28,   28,   29,   29,   29,   29,   29,   29,
+       29,   29,   29,   29,   29,   29,   29,   29,   29,   29,
+       29,   29,   29,   29,   29,   29,   29,   30,   30,   30,
+       30,   30,   30,   30,   30,   30,   30,   30,   30,   30,
+       30,   30,   30,   30,   30,   30,   30,   30,   30,   30,
+       31,   31,   31,   31,   31,   31,   31,   31,   31,   31,
+
+       31,   31,   31,   31,   31,   31,   31,   31,   31,   31,
+       31,   31,   31,   32,   32,   32,   32,   32,   32,   32,
+       32,   32,   32,   32,   32,   32,   32,   32,   32,   32,
+       32,   32,   32,   32,   32,   32,   33,   33,   33,   33,
+       33,   33,   33,   33,   33,   33,   33,   33,   33,   33,
+       33,   33,   33,   33,   33,   33,   33,   33,   33,   34,
+       34,   34,   34,   34,   34,   34,   34,   34,   34,   34,
+       34,   34,   34,   34,   34,   34,   34,   34,   34,   34,
+       34,   34,   35,   35,   35,   35,   35,   35,   35,   35,
+       35,   35,   35,   35,   35,   35,   35,   35,   35,   35,
+
+       35,   35,   35,   35,   35,   36,   36,   36,   36,   36,
+       36,   36,   36,   36,   36,   36,   36,   36,   36,   36,
+       36,   36,   36,   36,   36,   36,   36,   36,   37,   37,
+       37,   37,   37,   37,   37,   37,   37,   37,   37,   37,
+       37,   37,   37,   37,   37,   37,   37,   37,   37,   37,
+       37,   38,   38,   38,   38,   38,   38,   38,   38,   38,
+       38,   38,   38,   38,   38,   38,   38,   38,   38,   38,
+       38,   38,   38,   38,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   40,   40,   40,
+
+       40,   40,   40,   40,   40,   40,   40,   40,   40,   40,
+       40,   40,   40,   40,   40,   40,   40,   40,   40,   40,
+       41,   41,   41,   41,   41,   41,   41,   41,   41,   41,
+       41,   41,   41,   41,   41,   41,   41,   41,   41,   41,
+       41,   41,   41,   42,   42,   42,   42,   42,   42,   42,
+       42,   42,   42,   42,   42,   42,   42,   42,   42,   42,
+       42,   42,   42,   42,   42,   42,   43,   43,   43,   43,
+       43,   43,   43,   43,   43,   43,   43,   43,   43,   43,
+       43,   43,   43,   43,   43,   43,   43,   43,   43,   44,
+       44,   44,   44,   44,   44,   44,   44,   44,   44,   44,
+
+       44,   44,   44,   44,   44,   44,   44,   44,   44,   44,
+       44,   44,   45,   45,   45,   45,   45,   45,   45,   45,
+       45,   45,   45,   45,   45,   45,   45,   45,   45,   45,
+       45,   45,   45,   45,   45,   46,   46,   46,   46,   46,
+       46,   46,   46,   46,   46,   46,   46,   46,   46,   46,
+       46,   46,   46,   46,   46,   46,   46,   46,   47,   47,
+       47,   47,   47,   47,   47,   47,   47,   47,   47,   47,
+       47,   47,   47,   47,   47,   47,   47,   47,   47,   47,
+       47,   48,   48,   48,   48,   48,   48,   48,   48,   48,
+       48,   48,   48,   48,   48,   48,   48,   48,   48,   48,
+
+       48,   48,   48,   48,   49,   49,   49,   49,   49,   49,
+       49,   49,   49,   49,   49,   49,   49,   49,   49,   49,
+       49,   49,   49,   49,   49,   49,   49,   50,   50,   50,
+       50,   50,   50,   50,   50,   50,   50,   50,   50,   50,
+       50,   50,   50,   50,   50,   50,   50,   50,   50,   50,
+       51,   51,   51,   51,   51,   51,   51,   51,   51,   51,
+       51,   51,   51,   51,   51,   51,   51,   51,   51,   51,
+       51,   51,   51,   52,   52,   52,   52,   52,   52,   52,
+       52,   52,   52,   52,   52,   52,   52,   52,   52,   52,
+       52,   52,   52,   52,   52,   52,   53,   53,   53,   53,
+
+       53,   53,   53,   53,   53,   53,   53,   53,   53,   53,
+       53,   53,   53,   53,   53,   53,   53,   53,   53,   54,
+       54,   54,   54,   54,   54,   54,   54,   54,   54,   54,
+       54,   54,   54,   54,   54,   54,   54,   54,   54,   54,
+       54,   54,   55,   55,   55,   55,   55,   55,   55,   55,
        55,   55,   55,   55,   55,   55,   55,   55,   55,   55,
-       55,   55,   55,   55,   55,   55,   55,   55,   55
-
+       55,   55,   55,   55,   55,   56,   56,   56,   56,   56,
+       56,   56,   56,   56,   56,   56,   56,   56,   56,   56,
+       56,   56,   56,   56,   56,   56,   56,   56,   57,   57,
+       57,   57,   57,   57,   57,   57,   57,   57,   57,   57,
+
+       57,   57,   57,   57,   57,   57,   57,   57,   57,   57,
+       57,   58,   58,   58,   58,   58,   58,   58,   58,   58,
+       58,   58,   58,   58,   58,   58,   58,   58,   58,   58,
+       58,   58,   58,   58,   59,   59,   59,   59,   59,   59,
+       59,   59,   59,   59,   59,   59,   59,   59,   59,   59,
+       59,   59,   59,   59,   59,   59,   59,   60,   60,   60,
+       60,   60,   60,   60,   60,   60,   60,   60,   60,   60,
+       60,   60,   60,   60,   60,   60,   60,   60,   60,   60,
+       61,   61,   61,   61,   61,   61,   61,   61,   61,   61,
+       61,   61,   61,   61,   61,   61,   61,   61,   61,   61,
+
+       61,   61,   61,   62,   62,   62,   62,   62,   62,   62,
+       62,   62,   62,   62,   62,   62,   62,   62,   62,   62,
+       62,   62,   62,   62,   62,   62,   63,   63,   63,   63,
+       63,   63,   63,   63,   63,   63,   63,   63,   63,   63,
+       63,   63,   63,   63,   63,   63,   63,   63,   63,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64,   64,   64,   64,   64,   64,   64,   64,   64,
+       64,   64
     } ;
 
 /* The intent behind this definition is that it'll catch
@@ -677,7 +983,7 @@ static const flex_int16_t yy_chk[100] =
 #define YY_RESTORE_YY_MORE_OFFSET
 #line 1 "src/lexer.l"
 #define YY_NO_INPUT 1
-#line 8 "src/lexer.l"
+#line 9 "src/lexer.l"
 #include <stdarg.h>
 #include "derived-parser.h"
 
@@ -699,34 +1005,100 @@ static void yy_user_action(_SF1_YYLTYPE *yylloc, const char *my_yytext)
 
 static _sf1_syllable *syl (_sf1_parse_args *results, char *text, int flags) {
     size_t bufsize = strlen(text) + 1;
-    _sf1_syllable *syl = malloc(sizeof(*syl) + bufsize);
+    _sf1_syllable *syl = _sf1_malloc(sizeof(*syl) + bufsize);
     syl->flags = flags;
-    memcpy(syl->text, text, bufsize);
+    syl->splice = NULL;
+    syl->splice_count = 0;
+    memcpy(syl->buf, text, bufsize);
+    syl->text = syl->buf;
+    syl->next = NULL;
+    syl->next_word = NULL;
+    return syl;
+}
+/*
+ * Arguments outlive the parse and a blocking run, so they are referenced rather
+ * than copied.  Runs that go on after the call returns copy them first.
+ */
+static _sf1_syllable *syl_ref (_sf1_parse_args *results, const char *text, int flags) {
+    _sf1_syllable *syl = _sf1_malloc(sizeof(*syl));
+    syl->flags = flags|SYL_IS_REF;
+    syl->splice = NULL;
+    syl->splice_count = 0;
+    syl->text = text;
     syl->next = NULL;
     syl->next_word = NULL;
     return syl;
 }
+/*
+ * In a template, each argument is a slot holding the index of the argument (or of
+ * the first of count) that _sf1_template_bind() fills it in from.
+ */
+static _sf1_syllable *syl_slot (_sf1_parse_args *results, int flags, size_t count) {
+    _sf1_syllable *s = syl(results, "", flags|SYL_IS_SLOT);
+    s->arg = results->argi;
+    results->argi += count;
+    return s;
+}
+static _sf1_syllable *syl_arg (_sf1_parse_args *results, int flags) {
+    if (results->is_template) {
+        return syl_slot(results, flags, 1);
+    }
+    return syl_ref(results, _sf1_parse_next_str(results), flags);
+}
 static _sf1_syllable *syl_s (_sf1_parse_args *results) {
-    return syl(results, va_arg(*results->argpp, char *), SYL_ESCAPE_GLOB);
+    return syl_arg(results, SYL_ESCAPE_GLOB);
 }
 static _sf1_syllable *syl_file (_sf1_parse_args *results) {
-    return syl(results, va_arg(*results->argpp, char *), SYL_IS_FILE|SYL_ESCAPE_GLOB);
+    return syl_arg(results, SYL_IS_FILE|SYL_ESCAPE_GLOB);
 }
 static _sf1_syllable *syl_glob (_sf1_parse_args *results) {
-    return syl(results, va_arg(*results->argpp, char *), SYL_IS_FILE|SYL_IS_GLOB);
+    return syl_arg(results, SYL_IS_FILE|SYL_IS_GLOB);
 }
 static _sf1_syllable *syl_trusted_file (_sf1_parse_args *results) {
-    return syl(results, va_arg(*results->argpp, char *), SYL_IS_FILE|SYL_IS_TRUSTED|SYL_ESCAPE_GLOB);
+    return syl_arg(results, SYL_IS_FILE|SYL_IS_TRUSTED|SYL_ESCAPE_GLOB);
+}
+/*
+ * The strings are referenced in place, so only the array is recorded.
+ * Returns NULL if the array has a NULL in it.
+ */
+static _sf1_syllable *syl_splice (_sf1_parse_args *results, int flags) {
+    const char *const *splice;
+    size_t count;
+    _sf1_syllable *s;
+
+    if (results->is_template) {
+        return syl_slot(results, flags|SYL_IS_SPLICE, 2);
+    }
+    splice = _sf1_parse_next_strv(results);
+    count = _sf1_parse_next_size(results);
+    for (size_t i = 0; i < count; i++) {
+        if (!splice || !splice[i]) {
+            fprintf(stderr, "systemf: %%@ argument %zu of %zu is NULL\n", i, count);
+            return NULL;
+        }
+    }
+    s = syl(results, "", flags|SYL_IS_SPLICE);
+    s->splice = splice;
+    s->splice_count = count;
+    return s;
 }
 static _sf1_syllable *syl_d (_sf1_parse_args *results) {
     char text[20];
-    int val = va_arg(*results->argpp, int);
+    int val;
+
+    if (results->is_template) {
+        return syl_slot(results, SYL_IS_INT, 1);
+    }
+    val = _sf1_parse_next_int(results);
     snprintf(text, sizeof(text), "%d", val);
     return syl(results, text, 0);
 }
+static int fd (_sf1_parse_args *results) {
+    return results->is_template ? (int) results->argi++ : _sf1_parse_next_int(results);
+}
 
-#line 729 "src/derived-lexer.c"
-#line 730 "src/derived-lexer.c"
+#line 1101 "src/derived-lexer.c"
+#line 1102 "src/derived-lexer.c"
 
 #define INITIAL 0
 
@@ -998,10 +1370,10 @@ YY_DECL
 		}
 
 	{
-#line 58 "src/lexer.l"
+#line 125 "src/lexer.l"
 
 
-#line 1005 "src/derived-lexer.c"
+#line 1377 "src/derived-lexer.c"
 
 	while ( /*CONSTCOND*/1 )		/* loops until end-of-file is reached */
 		{
@@ -1028,13 +1400,13 @@ yy_match:
 			while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 				{
 				yy_current_state = (int) yy_def[yy_current_state];
-				if ( yy_current_state >= 56 )
+				if ( yy_current_state >= 65 )
 					yy_c = yy_meta[yy_c];
 				}
 			yy_current_state = yy_nxt[yy_base[yy_current_state] + yy_c];
 			++yy_cp;
 			}
-		while ( yy_base[yy_current_state] != 79 );
+		while ( yy_base[yy_current_state] != 1450 );
 
 yy_find_action:
 		yy_act = yy_accept[yy_current_state];
@@ -1060,126 +1432,151 @@ do_action:	/* This label is used only to access EOF actions. */
 
 case 1:
 YY_RULE_SETUP
-#line 60 "src/lexer.l"
+#line 127 "src/lexer.l"
 { yylval->SYLLABLE = syl(results, yytext, SYL_IS_TRUSTED); return SYLLABLE; }
 	YY_BREAK
 case 2:
 YY_RULE_SETUP
-#line 61 "src/lexer.l"
+#line 128 "src/lexer.l"
 { yylval->SYLLABLE = syl(results, yytext, SYL_IS_FILE|SYL_IS_GLOB|SYL_IS_TRUSTED); return SYLLABLE; }
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 62 "src/lexer.l"
+#line 129 "src/lexer.l"
 { yylval->SYLLABLE = syl(results, yytext, SYL_IS_FILE|SYL_IS_GLOB|SYL_IS_TRUSTED); return SYLLABLE; }
 	YY_BREAK
 case 4:
 YY_RULE_SETUP
-#line 63 "src/lexer.l"
+#line 130 "src/lexer.l"
 { yylval->SYLLABLE = syl_s(results); return SYLLABLE; }
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 64 "src/lexer.l"
+#line 131 "src/lexer.l"
 { yylval->SYLLABLE = syl_file(results); return SYLLABLE; }
 	YY_BREAK
 case 6:
 YY_RULE_SETUP
-#line 65 "src/lexer.l"
+#line 132 "src/lexer.l"
 { yylval->SYLLABLE = syl_trusted_file(results); return SYLLABLE; }
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 66 "src/lexer.l"
+#line 133 "src/lexer.l"
 { yylval->SYLLABLE = syl_glob(results); return SYLLABLE; }
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 67 "src/lexer.l"
+#line 134 "src/lexer.l"
 { yylval->SYLLABLE = syl_d(results); return SYLLABLE; }
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 68 "src/lexer.l"
-{ return SPACE;}
+#line 135 "src/lexer.l"
+{ yylval->FD = fd(results); return FD; }
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 69 "src/lexer.l"
-{ return LESSER; }
+#line 136 "src/lexer.l"
+{ yylval->SPLICE = syl_splice(results, 0); return yylval->SPLICE ? SPLICE : BAD_ARG; }
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-#line 70 "src/lexer.l"
-{ return TWO_GREATER_AND_ONE; }
+#line 137 "src/lexer.l"
+{ yylval->SPLICE = syl_splice(results, SYL_IS_FILE); return yylval->SPLICE ? SPLICE : BAD_ARG; }
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-#line 71 "src/lexer.l"
-{ return TWO_GREATER; }
+#line 138 "src/lexer.l"
+{ return SPACE;}
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
-#line 72 "src/lexer.l"
-{ return AND_GREATER; }
+#line 139 "src/lexer.l"
+{ return LESSER; }
 	YY_BREAK
 case 14:
 YY_RULE_SETUP
-#line 73 "src/lexer.l"
-{ return GREATER; }
+#line 140 "src/lexer.l"
+{ return TWO_GREATER_AND_ONE; }
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 74 "src/lexer.l"
-{ return GREATER_AND_TWO; }
+#line 141 "src/lexer.l"
+{ return TWO_GREATER; }
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-#line 75 "src/lexer.l"
-{ return TWO_GREATER_GREATER; }
+#line 142 "src/lexer.l"
+{ return AND_GREATER; }
 	YY_BREAK
 case 17:
 YY_RULE_SETUP
-#line 76 "src/lexer.l"
-{ return AND_GREATER_GREATER; }
+#line 143 "src/lexer.l"
+{ return GREATER; }
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
-#line 77 "src/lexer.l"
-{ return GREATER_GREATER; }
+#line 144 "src/lexer.l"
+{ return GREATER_AND_TWO; }
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
-#line 78 "src/lexer.l"
-{ return AND_AND; }
+#line 145 "src/lexer.l"
+{ return TWO_GREATER_GREATER; }
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
-#line 79 "src/lexer.l"
-{ return OR; }
+#line 146 "src/lexer.l"
+{ return AND_GREATER_GREATER; }
 	YY_BREAK
 case 21:
 YY_RULE_SETUP
-#line 80 "src/lexer.l"
-{ return OR_OR; }
+#line 147 "src/lexer.l"
+{ return GREATER_GREATER; }
 	YY_BREAK
 case 22:
 YY_RULE_SETUP
-#line 81 "src/lexer.l"
-{ return SEMICOLON; }
+#line 148 "src/lexer.l"
+{ return AND_AND; }
 	YY_BREAK
 case 23:
-/* rule 23 can match eol */
 YY_RULE_SETUP
-#line 82 "src/lexer.l"
-{ return yytext[0]; }
+#line 149 "src/lexer.l"
+{ return OR; }
 	YY_BREAK
 case 24:
 YY_RULE_SETUP
-#line 84 "src/lexer.l"
+#line 150 "src/lexer.l"
+{ return OR_GREATER; }
+	YY_BREAK
+case 25:
+YY_RULE_SETUP
+#line 151 "src/lexer.l"
+{ return OR_GREATER_GREATER; }
+	YY_BREAK
+case 26:
+YY_RULE_SETUP
+#line 152 "src/lexer.l"
+{ return OR_OR; }
+	YY_BREAK
+case 27:
+YY_RULE_SETUP
+#line 153 "src/lexer.l"
+{ return SEMICOLON; }
+	YY_BREAK
+case 28:
+/* rule 28 can match eol */
+YY_RULE_SETUP
+#line 154 "src/lexer.l"
+{ return yytext[0]; }
+	YY_BREAK
+case 29:
+YY_RULE_SETUP
+#line 156 "src/lexer.l"
 ECHO;
 	YY_BREAK
-#line 1183 "src/derived-lexer.c"
+#line 1580 "src/derived-lexer.c"
 case YY_STATE_EOF(INITIAL):
 	yyterminate();
 
@@ -1478,7 +1875,7 @@ static int yy_get_next_buffer (yyscan_t yyscanner)
 		while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 			{
 			yy_current_state = (int) yy_def[yy_current_state];
-			if ( yy_current_state >= 56 )
+			if ( yy_current_state >= 65 )
 				yy_c = yy_meta[yy_c];
 			}
 		yy_current_state = yy_nxt[yy_base[yy_current_state] + yy_c];
@@ -1507,11 +1904,11 @@ static int yy_get_next_buffer (yyscan_t yyscanner)
 	while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 		{
 		yy_current_state = (int) yy_def[yy_current_state];
-		if ( yy_current_state >= 56 )
+		if ( yy_current_state >= 65 )
 			yy_c = yy_meta[yy_c];
 		}
 	yy_current_state = yy_nxt[yy_base[yy_current_state] + yy_c];
-	yy_is_jam = (yy_current_state == 55);
+	yy_is_jam = (yy_current_state == 64);
 
 	(void)yyg;
 	return yy_is_jam ? 0 : yy_current_state;
@@ -2291,38 +2688,24 @@ static int yy_flex_strlen (const char * s , yyscan_t yyscanner)
 }
 #endif
 
-void *yyalloc (yy_size_t  size , yyscan_t yyscanner)
-{
-	struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
-	(void)yyg;
-	return malloc(size);
-}
+#define YYTABLES_NAME "yytables"
 
-void *yyrealloc  (void * ptr, yy_size_t  size , yyscan_t yyscanner)
-{
-	struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
-	(void)yyg;
+#line 156 "src/lexer.l"
 
-	/* The cast to (char *) in the following accommodates both
-	 * implementations that use char* generic pointers, and those
-	 * that use void* generic pointers.  It works with the latter
-	 * because both ANSI C and C++ allow castless assignment from
-	 * any pointer type to void*, and deal with argument conversions
-	 * as though doing an assignment.
-	 */
-	return realloc(ptr, size);
-}
 
-void yyfree (void * ptr , yyscan_t yyscanner)
-{
-	struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
-	(void)yyg;
-	free( (char *) ptr );	/* see yyrealloc() for (char *) cast */
+/*
+ * The scanner allocates through systemf1_set_allocator() like the rest of systemf.
+ */
+void *yyalloc(yy_size_t size, yyscan_t yyscanner) {
+    return _sf1_malloc(size);
 }
 
-#define YYTABLES_NAME "yytables"
-
-#line 84 "src/lexer.l"
+void *yyrealloc(void *ptr, yy_size_t size, yyscan_t yyscanner) {
+    return _sf1_realloc(ptr, size);
+}
 
+void yyfree(void *ptr, yyscan_t yyscanner) {
+    _sf1_free(ptr);
+}
 
 
@@ -1,8 +1,8 @@
-/* A Bison parser, made by GNU Bison 3.5.1.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison implementation for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2020 Free Software Foundation,
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
    Inc.
 
    This program is free software: you can redistribute it and/or modify
@@ -16,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -34,6 +34,10 @@
 /* C LALR(1) parser skeleton written by Richard Stallman, by
    simplifying the original so-called "semantic" parser.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 /* All symbols defined below should begin with yy or YY, to avoid
    infringing on user name space.  This should be done even for local
    variables, as they might otherwise be expanded by user macros.
@@ -41,14 +45,11 @@
    define necessary library symbols; they are noted "INFRINGES ON
    USER NAME SPACE" below.  */
 
-/* Undocumented macros, especially those whose name start with YY_,
-   are private implementation details.  Do not rely on them.  */
-
-/* Identify Bison output.  */
-#define YYBISON 1
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
 
-/* Bison version.  */
-#define YYBISON_VERSION "3.5.1"
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
@@ -94,128 +95,46 @@
 #  endif
 # endif
 
-/* Enabling verbose error messages.  */
-#ifdef YYERROR_VERBOSE
-# undef YYERROR_VERBOSE
-# define YYERROR_VERBOSE 1
-#else
-# define YYERROR_VERBOSE 0
-#endif
-
-/* Use api.header.include to #include this header
-   instead of duplicating it here.  */
-#ifndef YY__SF1_YY_SRC_DERIVED_PARSER_H_INCLUDED
-# define YY__SF1_YY_SRC_DERIVED_PARSER_H_INCLUDED
-/* Debug traces.  */
-#ifndef _SF1_YYDEBUG
-# if defined YYDEBUG
-#if YYDEBUG
-#   define _SF1_YYDEBUG 1
-#  else
-#   define _SF1_YYDEBUG 0
-#  endif
-# else /* ! defined YYDEBUG */
-#  define _SF1_YYDEBUG 0
-# endif /* ! defined YYDEBUG */
-#endif  /* ! defined _SF1_YYDEBUG */
-#if _SF1_YYDEBUG
-extern int _sf1_yydebug;
-#endif
-/* "%code requires" blocks.  */
-#line 13 "src/parser.y"
-
-    #if 1 // This compiles in debug code enabled by _sf1_yydebug;
-        #undef SYSTEMF1_YYDEBUG
-        #define SYSTEMF1_YYDEBUG 1
-        extern int _sf1_yydebug;
-    #endif
-
-    #include "systemf-internal.h"
-
-
-#line 137 "src/derived-parser.c"
-
-/* Token type.  */
-#ifndef _SF1_YYTOKENTYPE
-# define _SF1_YYTOKENTYPE
-  enum _sf1_yytokentype
-  {
-    SYLLABLE = 258,
-    SPACE = 259,
-    QUOTE = 260,
-    LESSER = 261,
-    TWO_GREATER_AND_ONE = 262,
-    TWO_GREATER = 263,
-    AND_GREATER = 264,
-    GREATER = 265,
-    TWO_GREATER_GREATER = 266,
-    AND_GREATER_GREATER = 267,
-    GREATER_GREATER = 268,
-    GREATER_AND_TWO = 269,
-    AND_AND = 270,
-    OR_OR = 271,
-    SEMICOLON = 272,
-    OR = 273
-  };
-#endif
-
-/* Value type.  */
-#if ! defined _SF1_YYSTYPE && ! defined _SF1_YYSTYPE_IS_DECLARED
-union _SF1_YYSTYPE
+#include "derived-parser.h"
+/* Symbol kind.  */
+enum yysymbol_kind_t
 {
-
-  /* redirects  */
-  _sf1_redirect * redirects;
-  /* redirect  */
-  _sf1_redirect * redirect;
-  /* SYLLABLE  */
-  _sf1_syllable * SYLLABLE;
-  /* words  */
-  _sf1_syllable * words;
-  /* syllables  */
-  _sf1_syllable * syllables;
-  /* cmds  */
-  _sf1_task * cmds;
-  /* cmd  */
-  _sf1_task * cmd;
-#line 182 "src/derived-parser.c"
-
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_SYLLABLE = 3,                   /* SYLLABLE  */
+  YYSYMBOL_SPLICE = 4,                     /* SPLICE  */
+  YYSYMBOL_FD = 5,                         /* FD  */
+  YYSYMBOL_BAD_ARG = 6,                    /* BAD_ARG  */
+  YYSYMBOL_SPACE = 7,                      /* SPACE  */
+  YYSYMBOL_QUOTE = 8,                      /* QUOTE  */
+  YYSYMBOL_LESSER = 9,                     /* LESSER  */
+  YYSYMBOL_TWO_GREATER_AND_ONE = 10,       /* TWO_GREATER_AND_ONE  */
+  YYSYMBOL_TWO_GREATER = 11,               /* TWO_GREATER  */
+  YYSYMBOL_AND_GREATER = 12,               /* AND_GREATER  */
+  YYSYMBOL_GREATER = 13,                   /* GREATER  */
+  YYSYMBOL_TWO_GREATER_GREATER = 14,       /* TWO_GREATER_GREATER  */
+  YYSYMBOL_AND_GREATER_GREATER = 15,       /* AND_GREATER_GREATER  */
+  YYSYMBOL_GREATER_GREATER = 16,           /* GREATER_GREATER  */
+  YYSYMBOL_GREATER_AND_TWO = 17,           /* GREATER_AND_TWO  */
+  YYSYMBOL_AND_AND = 18,                   /* AND_AND  */
+  YYSYMBOL_OR_OR = 19,                     /* OR_OR  */
+  YYSYMBOL_SEMICOLON = 20,                 /* SEMICOLON  */
+  YYSYMBOL_OR = 21,                        /* OR  */
+  YYSYMBOL_OR_GREATER = 22,                /* OR_GREATER  */
+  YYSYMBOL_OR_GREATER_GREATER = 23,        /* OR_GREATER_GREATER  */
+  YYSYMBOL_YYACCEPT = 24,                  /* $accept  */
+  YYSYMBOL_top = 25,                       /* top  */
+  YYSYMBOL_cmds = 26,                      /* cmds  */
+  YYSYMBOL_cmd = 27,                       /* cmd  */
+  YYSYMBOL_redirects = 28,                 /* redirects  */
+  YYSYMBOL_redirect = 29,                  /* redirect  */
+  YYSYMBOL_words = 30,                     /* words  */
+  YYSYMBOL_syllables = 31                  /* syllables  */
 };
-typedef union _SF1_YYSTYPE _SF1_YYSTYPE;
-# define _SF1_YYSTYPE_IS_TRIVIAL 1
-# define _SF1_YYSTYPE_IS_DECLARED 1
-#endif
+typedef enum yysymbol_kind_t yysymbol_kind_t;
 
-/* Location type.  */
-#if ! defined _SF1_YYLTYPE && ! defined _SF1_YYLTYPE_IS_DECLARED
-typedef struct _SF1_YYLTYPE _SF1_YYLTYPE;
-struct _SF1_YYLTYPE
-{
-  int first_line;
-  int first_column;
-  int last_line;
-  int last_column;
-};
-# define _SF1_YYLTYPE_IS_DECLARED 1
-# define _SF1_YYLTYPE_IS_TRIVIAL 1
-#endif
-
-
-
-int _sf1_yyparse (yyscan_t scanner, _sf1_parse_args *results);
-/* "%code provides" blocks.  */
-#line 25 "src/parser.y"
-
-    #define YYSTYPE _SF1_YYSTYPE
-    #define YYLTYPE _SF1_YYLTYPE
-    #define YY_DECL int _sf1_yylex(YYSTYPE * yylval_param , YYLTYPE *yylloc, yyscan_t yyscanner, _sf1_parse_args *results)
-    extern YY_DECL;
-
-    int _sf1_yyerror(_SF1_YYLTYPE *locp, yyscan_t scanner, _sf1_parse_args *results, const char *msg);
-
-#line 217 "src/derived-parser.c"
-
-#endif /* !YY__SF1_YY_SRC_DERIVED_PARSER_H_INCLUDED  */
 
 
 /* Unqualified %code blocks.  */
@@ -227,7 +146,11 @@ int _sf1_yyparse (yyscan_t scanner, _sf1_parse_args *results);
      */
     #include "systemf-internal.h"
 
-#line 231 "src/derived-parser.c"
+    // The parser's stack grows through the allocator from systemf1_set_allocator().
+    #define YYMALLOC _sf1_malloc
+    #define YYFREE _sf1_free
+
+#line 154 "src/derived-parser.c"
 
 #ifdef short
 # undef short
@@ -266,6 +189,18 @@ typedef int_least16_t yytype_int16;
 typedef short yytype_int16;
 #endif
 
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
 #if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
 typedef __UINT_LEAST8_TYPE__ yytype_uint8;
 #elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
@@ -325,6 +260,7 @@ typedef int yytype_uint16;
 
 #define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
 
+
 /* Stored state numbers (used for stacks). */
 typedef yytype_int8 yy_state_t;
 
@@ -343,6 +279,7 @@ typedef int yy_state_fast_t;
 # endif
 #endif
 
+
 #ifndef YY_ATTRIBUTE_PURE
 # if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
 #  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
@@ -361,17 +298,23 @@ typedef int yy_state_fast_t;
 
 /* Suppress unused-variable warnings by "using" E.  */
 #if ! defined lint || defined __GNUC__
-# define YYUSE(E) ((void) (E))
+# define YY_USE(E) ((void) (E))
 #else
-# define YYUSE(E) /* empty */
+# define YY_USE(E) /* empty */
 #endif
 
-#if defined __GNUC__ && ! defined __ICC && 407 <= __GNUC__ * 100 + __GNUC_MINOR__
 /* Suppress an incorrect diagnostic about yylval being uninitialized.  */
-# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                            \
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
     _Pragma ("GCC diagnostic push")                                     \
     _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
     _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
 # define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
     _Pragma ("GCC diagnostic pop")
 #else
@@ -400,7 +343,7 @@ typedef int yy_state_fast_t;
 
 #define YY_ASSERT(E) ((void) (0 && (E)))
 
-#if ! defined yyoverflow || YYERROR_VERBOSE
+#if !defined yyoverflow
 
 /* The parser invokes alloca or malloc; define the necessary symbols.  */
 
@@ -465,8 +408,7 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 # endif
-#endif /* ! defined yyoverflow || YYERROR_VERBOSE */
-
+#endif /* !defined yyoverflow */
 
 #if (! defined yyoverflow \
      && (! defined __cplusplus \
@@ -532,27 +474,29 @@ union yyalloc
 #endif /* !YYCOPY_NEEDED */
 
 /* YYFINAL -- State number of the termination state.  */
-#define YYFINAL  8
+#define YYFINAL  11
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   32
+#define YYLAST   50
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  19
+#define YYNTOKENS  24
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  7
+#define YYNNTS  8
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  24
+#define YYNRULES  33
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  38
+#define YYNSTATES  54
 
-#define YYUNDEFTOK  2
-#define YYMAXUTOK   273
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   278
 
 
 /* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
    as returned by yylex, with out-of-bounds checking.  */
-#define YYTRANSLATE(YYX)                                                \
-  (0 <= (YYX) && (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
 
 /* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
    as returned by yylex.  */
@@ -585,43 +529,49 @@ static const yytype_int8 yytranslate[] =
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
        5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
-      15,    16,    17,    18
+      15,    16,    17,    18,    19,    20,    21,    22,    23
 };
 
 #if _SF1_YYDEBUG
-  /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_int8 yyrline[] =
 {
-       0,    52,    52,    53,    54,    55,    56,    60,    63,    64,
-      65,    68,    69,    70,    71,    72,    73,    74,    75,    77,
-      81,    82,    83,    86,    87
+       0,    66,    66,    69,    70,    71,    72,    73,    75,    76,
+      79,    82,    83,    84,    90,    91,    92,    93,    94,    95,
+      96,    97,    98,    99,   100,   101,   102,   105,   106,   107,
+     108,   109,   112,   113
 };
 #endif
 
-#if _SF1_YYDEBUG || YYERROR_VERBOSE || 0
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if _SF1_YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
 /* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
    First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
 static const char *const yytname[] =
 {
-  "$end", "error", "$undefined", "SYLLABLE", "SPACE", "QUOTE", "LESSER",
-  "TWO_GREATER_AND_ONE", "TWO_GREATER", "AND_GREATER", "GREATER",
-  "TWO_GREATER_GREATER", "AND_GREATER_GREATER", "GREATER_GREATER",
-  "GREATER_AND_TWO", "AND_AND", "OR_OR", "SEMICOLON", "OR", "$accept",
-  "cmds", "cmd", "redirects", "redirect", "words", "syllables", YY_NULLPTR
+  "\"end of file\"", "error", "\"invalid token\"", "SYLLABLE", "SPLICE",
+  "FD", "BAD_ARG", "SPACE", "QUOTE", "LESSER", "TWO_GREATER_AND_ONE",
+  "TWO_GREATER", "AND_GREATER", "GREATER", "TWO_GREATER_GREATER",
+  "AND_GREATER_GREATER", "GREATER_GREATER", "GREATER_AND_TWO", "AND_AND",
+  "OR_OR", "SEMICOLON", "OR", "OR_GREATER", "OR_GREATER_GREATER",
+  "$accept", "top", "cmds", "cmd", "redirects", "redirect", "words",
+  "syllables", YY_NULLPTR
 };
-#endif
 
-# ifdef YYPRINT
-/* YYTOKNUM[NUM] -- (External) token number corresponding to the
-   (internal) symbol number NUM (which must be that of a token).  */
-static const yytype_int16 yytoknum[] =
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
 {
-       0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
-     265,   266,   267,   268,   269,   270,   271,   272,   273
-};
-# endif
+  return yytname[yysymbol];
+}
+#endif
 
-#define YYPACT_NINF (-6)
+#define YYPACT_NINF (-13)
 
 #define yypact_value_is_default(Yyn) \
   ((Yyn) == YYPACT_NINF)
@@ -631,100 +581,113 @@ static const yytype_int16 yytoknum[] =
 #define yytable_value_is_error(Yyn) \
   0
 
-  /* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-     STATE-NUM.  */
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
 static const yytype_int8 yypact[] =
 {
-       9,    -6,    24,    28,     4,    -5,    25,    -6,    -6,     9,
-       9,     9,     9,    24,    -6,    24,    24,    24,    24,    24,
-      24,    -6,    -6,    -5,     9,    -6,    -6,    -6,    -6,    -6,
-      -6,    -6,    -6,    -6,    -6,    -6,    -6,    -6
+       4,   -13,     3,     9,    17,   -13,    -8,    20,    14,   -13,
+       4,   -13,     4,     4,     4,     4,     3,     3,    37,   -13,
+      38,    41,    42,     3,     3,     3,   -13,   -13,    20,     4,
+     -13,   -13,   -13,   -13,   -13,    27,    28,   -13,   -13,   -13,
+     -13,   -13,   -13,   -13,   -13,   -13,   -13,   -13,   -13,   -13,
+       4,     4,   -13,   -13
 };
 
-  /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
-     Performed when YYTABLE does not specify something else to do.  Zero
-     means the default is an error.  */
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
 static const yytype_int8 yydefact[] =
 {
-       0,    22,    23,     0,     2,    10,    20,    24,     1,     0,
-       0,     0,     0,     0,    15,     0,     0,     0,     0,     0,
-       0,    14,     7,     9,     0,     5,     4,     3,     6,    11,
-      16,    18,    12,    17,    19,    13,     8,    21
+       0,    31,    32,    29,     0,     2,     3,    13,    27,    33,
+       0,     1,     0,     0,     0,     0,     0,     0,     0,    18,
+       0,     0,     0,     0,     0,     0,    17,    10,    12,     0,
+      30,     6,     5,     4,     7,     0,     0,    23,    14,    25,
+      19,    26,    21,    24,    15,    20,    22,    16,    11,    28,
+       0,     0,     8,     9
 };
 
-  /* YYPGOTO[NTERM-NUM].  */
+/* YYPGOTO[NTERM-NUM].  */
 static const yytype_int8 yypgoto[] =
 {
-      -6,    14,    -6,     7,    -6,     8,    -2
+     -13,   -13,   -12,   -13,    22,   -13,    -1,     2
 };
 
-  /* YYDEFGOTO[NTERM-NUM].  */
+/* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int8 yydefgoto[] =
 {
-      -1,     3,     4,    22,    23,     5,     6
+       0,     4,     5,     6,    27,    28,     7,     8
 };
 
-  /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
-     positive, shift that token.  If negative, reduce the rule whose
-     number is the opposite.  If YYTABLE_NINF, syntax error.  */
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_int8 yytable[] =
 {
-       7,    13,    14,    15,    16,    17,    18,    19,    20,    21,
-       1,    29,     2,    30,    31,    32,    33,    34,    35,     9,
-      10,    11,    12,    25,    26,    27,    28,     2,     8,    24,
-      36,     0,    37
+      31,    32,    33,    34,     9,     1,     2,     2,     3,    30,
+      12,    13,    14,    15,    16,    17,    10,    11,    35,    36,
+      38,    29,    40,    42,    44,    45,    46,    47,    49,    18,
+      19,    20,    21,    22,    23,    24,    25,    26,    52,    53,
+       2,     2,    37,    39,     2,     2,    41,    43,    50,    51,
+      48
 };
 
 static const yytype_int8 yycheck[] =
 {
-       2,     6,     7,     8,     9,    10,    11,    12,    13,    14,
-       1,    13,     3,    15,    16,    17,    18,    19,    20,    15,
-      16,    17,    18,     9,    10,    11,    12,     3,     0,     4,
-      23,    -1,    24
+      12,    13,    14,    15,     2,     1,     3,     3,     4,    10,
+      18,    19,    20,    21,    22,    23,     7,     0,    16,    17,
+      18,     7,    20,    21,    22,    23,    24,    25,    29,     9,
+      10,    11,    12,    13,    14,    15,    16,    17,    50,    51,
+       3,     3,     5,     5,     3,     3,     5,     5,    21,    21,
+      28
 };
 
-  /* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-     symbol of state STATE-NUM.  */
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
 static const yytype_int8 yystos[] =
 {
-       0,     1,     3,    20,    21,    24,    25,    25,     0,    15,
-      16,    17,    18,     6,     7,     8,     9,    10,    11,    12,
-      13,    14,    22,    23,     4,    20,    20,    20,    20,    25,
-      25,    25,    25,    25,    25,    25,    22,    24
+       0,     1,     3,     4,    25,    26,    27,    30,    31,    31,
+       7,     0,    18,    19,    20,    21,    22,    23,     9,    10,
+      11,    12,    13,    14,    15,    16,    17,    28,    29,     7,
+      30,    26,    26,    26,    26,    31,    31,     5,    31,     5,
+      31,     5,    31,     5,    31,    31,    31,    31,    28,    30,
+      21,    21,    26,    26
 };
 
-  /* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr1[] =
 {
-       0,    19,    20,    20,    20,    20,    20,    21,    22,    22,
-      22,    23,    23,    23,    23,    23,    23,    23,    23,    23,
-      24,    24,    24,    25,    25
+       0,    24,    25,    26,    26,    26,    26,    26,    26,    26,
+      27,    28,    28,    28,    29,    29,    29,    29,    29,    29,
+      29,    29,    29,    29,    29,    29,    29,    30,    30,    30,
+      30,    30,    31,    31
 };
 
-  /* YYR2[YYN] -- Number of symbols on the right hand side of rule YYN.  */
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr2[] =
 {
-       0,     2,     1,     3,     3,     3,     3,     2,     2,     1,
-       0,     2,     2,     2,     1,     1,     2,     2,     2,     2,
-       1,     3,     1,     1,     2
+       0,     2,     1,     1,     3,     3,     3,     3,     5,     5,
+       2,     2,     1,     0,     2,     2,     2,     1,     1,     2,
+       2,     2,     2,     2,     2,     2,     2,     1,     3,     1,
+       3,     1,     1,     2
 };
 
 
+enum { YYENOMEM = -2 };
+
 #define yyerrok         (yyerrstatus = 0)
-#define yyclearin       (yychar = YYEMPTY)
-#define YYEMPTY         (-2)
-#define YYEOF           0
+#define yyclearin       (yychar = _SF1_YYEMPTY)
 
 #define YYACCEPT        goto yyacceptlab
 #define YYABORT         goto yyabortlab
 #define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
 
 
 #define YYRECOVERING()  (!!yyerrstatus)
 
 #define YYBACKUP(Token, Value)                                    \
   do                                                              \
-    if (yychar == YYEMPTY)                                        \
+    if (yychar == _SF1_YYEMPTY)                                        \
       {                                                           \
         yychar = (Token);                                         \
         yylval = (Value);                                         \
@@ -739,10 +702,9 @@ static const yytype_int8 yyr2[] =
       }                                                           \
   while (0)
 
-/* Error token number */
-#define YYTERROR        1
-#define YYERRCODE       256
-
+/* Backward compatibility with an undocumented macro.
+   Use _SF1_YYerror or _SF1_YYUNDEF. */
+#define YYERRCODE _SF1_YYUNDEF
 
 /* YYLLOC_DEFAULT -- Set CURRENT to span from RHS[1] to RHS[N].
    If N is 0, then set CURRENT to the empty location which ends
@@ -786,12 +748,19 @@ do {                                            \
 } while (0)
 
 
-/* YY_LOCATION_PRINT -- Print the location on the stream.
+/* YYLOCATION_PRINT -- Print the location on the stream.
    This macro was not mandated originally: define only if we know
    we won't break user code: when these are the locations we know.  */
 
-#ifndef YY_LOCATION_PRINT
-# if defined _SF1_YYLTYPE_IS_TRIVIAL && _SF1_YYLTYPE_IS_TRIVIAL
+# ifndef YYLOCATION_PRINT
+
+#  if defined YY_LOCATION_PRINT
+
+   /* Temporary convenience wrapper in case some people defined the
+      undocumented and private YY_LOCATION_PRINT macros.  */
+#   define YYLOCATION_PRINT(File, Loc)  YY_LOCATION_PRINT(File, *(Loc))
+
+#  elif defined _SF1_YYLTYPE_IS_TRIVIAL && _SF1_YYLTYPE_IS_TRIVIAL
 
 /* Print *YYLOCP on YYO.  Private, do not rely on its existence. */
 
@@ -819,24 +788,32 @@ yy_location_print_ (FILE *yyo, YYLTYPE const * const yylocp)
         res += YYFPRINTF (yyo, "-%d", end_col);
     }
   return res;
- }
+}
 
-#  define YY_LOCATION_PRINT(File, Loc)          \
-  yy_location_print_ (File, &(Loc))
+#   define YYLOCATION_PRINT  yy_location_print_
 
-# else
-#  define YY_LOCATION_PRINT(File, Loc) ((void) 0)
-# endif
-#endif
+    /* Temporary convenience wrapper in case some people defined the
+       undocumented and private YY_LOCATION_PRINT macros.  */
+#   define YY_LOCATION_PRINT(File, Loc)  YYLOCATION_PRINT(File, &(Loc))
+
+#  else
+
+#   define YYLOCATION_PRINT(File, Loc) ((void) 0)
+    /* Temporary convenience wrapper in case some people defined the
+       undocumented and private YY_LOCATION_PRINT macros.  */
+#   define YY_LOCATION_PRINT  YYLOCATION_PRINT
+
+#  endif
+# endif /* !defined YYLOCATION_PRINT */
 
 
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)                    \
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
 do {                                                                      \
   if (yydebug)                                                            \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value, Location, scanner, results); \
+                  Kind, Value, Location, scanner, results); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -847,21 +824,18 @@ do {                                                                      \
 `-----------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, yyscan_t scanner, _sf1_parse_args *results)
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, yyscan_t scanner, _sf1_parse_args *results)
 {
   FILE *yyoutput = yyo;
-  YYUSE (yyoutput);
-  YYUSE (yylocationp);
-  YYUSE (scanner);
-  YYUSE (results);
+  YY_USE (yyoutput);
+  YY_USE (yylocationp);
+  YY_USE (scanner);
+  YY_USE (results);
   if (!yyvaluep)
     return;
-# ifdef YYPRINT
-  if (yytype < YYNTOKENS)
-    YYPRINT (yyo, yytoknum[yytype], *yyvaluep);
-# endif
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  YYUSE (yytype);
+  YY_USE (yykind);
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
@@ -871,14 +845,15 @@ yy_symbol_value_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep, YY
 `---------------------------*/
 
 static void
-yy_symbol_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, yyscan_t scanner, _sf1_parse_args *results)
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, yyscan_t scanner, _sf1_parse_args *results)
 {
   YYFPRINTF (yyo, "%s %s (",
-             yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  YY_LOCATION_PRINT (yyo, *yylocationp);
+  YYLOCATION_PRINT (yyo, yylocationp);
   YYFPRINTF (yyo, ": ");
-  yy_symbol_value_print (yyo, yytype, yyvaluep, yylocationp, scanner, results);
+  yy_symbol_value_print (yyo, yykind, yyvaluep, yylocationp, scanner, results);
   YYFPRINTF (yyo, ")");
 }
 
@@ -911,7 +886,8 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule, yyscan_t scanner, _sf1_parse_args *results)
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp,
+                 int yyrule, yyscan_t scanner, _sf1_parse_args *results)
 {
   int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -923,9 +899,9 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule,
     {
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
-                       yystos[+yyssp[yyi + 1 - yynrhs]],
-                       &yyvsp[(yyi + 1) - (yynrhs)]
-                       , &(yylsp[(yyi + 1) - (yynrhs)])                       , scanner, results);
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)],
+                       &(yylsp[(yyi + 1) - (yynrhs)]), scanner, results);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -940,8 +916,8 @@ do {                                    \
    multiple parsers can coexist.  */
 int yydebug;
 #else /* !_SF1_YYDEBUG */
-# define YYDPRINTF(Args)
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
 # define YY_STACK_PRINT(Bottom, Top)
 # define YY_REDUCE_PRINT(Rule)
 #endif /* !_SF1_YYDEBUG */
@@ -964,261 +940,88 @@ int yydebug;
 #endif
 
 
-#if YYERROR_VERBOSE
-
-# ifndef yystrlen
-#  if defined __GLIBC__ && defined _STRING_H
-#   define yystrlen(S) (YY_CAST (YYPTRDIFF_T, strlen (S)))
-#  else
-/* Return the length of YYSTR.  */
-static YYPTRDIFF_T
-yystrlen (const char *yystr)
-{
-  YYPTRDIFF_T yylen;
-  for (yylen = 0; yystr[yylen]; yylen++)
-    continue;
-  return yylen;
-}
-#  endif
-# endif
-
-# ifndef yystpcpy
-#  if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
-#   define yystpcpy stpcpy
-#  else
-/* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
-   YYDEST.  */
-static char *
-yystpcpy (char *yydest, const char *yysrc)
-{
-  char *yyd = yydest;
-  const char *yys = yysrc;
-
-  while ((*yyd++ = *yys++) != '\0')
-    continue;
-
-  return yyd - 1;
-}
-#  endif
-# endif
-
-# ifndef yytnamerr
-/* Copy to YYRES the contents of YYSTR after stripping away unnecessary
-   quotes and backslashes, so that it's suitable for yyerror.  The
-   heuristic is that double-quoting is unnecessary unless the string
-   contains an apostrophe, a comma, or backslash (other than
-   backslash-backslash).  YYSTR is taken from yytname.  If YYRES is
-   null, do not copy; instead, return the length of what the result
-   would have been.  */
-static YYPTRDIFF_T
-yytnamerr (char *yyres, const char *yystr)
-{
-  if (*yystr == '"')
-    {
-      YYPTRDIFF_T yyn = 0;
-      char const *yyp = yystr;
-
-      for (;;)
-        switch (*++yyp)
-          {
-          case '\'':
-          case ',':
-            goto do_not_strip_quotes;
-
-          case '\\':
-            if (*++yyp != '\\')
-              goto do_not_strip_quotes;
-            else
-              goto append;
-
-          append:
-          default:
-            if (yyres)
-              yyres[yyn] = *yyp;
-            yyn++;
-            break;
-
-          case '"':
-            if (yyres)
-              yyres[yyn] = '\0';
-            return yyn;
-          }
-    do_not_strip_quotes: ;
-    }
-
-  if (yyres)
-    return yystpcpy (yyres, yystr) - yyres;
-  else
-    return yystrlen (yystr);
-}
-# endif
-
-/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
-   about the unexpected token YYTOKEN for the state stack whose top is
-   YYSSP.
-
-   Return 0 if *YYMSG was successfully written.  Return 1 if *YYMSG is
-   not large enough to hold the message.  In that case, also set
-   *YYMSG_ALLOC to the required number of bytes.  Return 2 if the
-   required number of bytes is too large to store.  */
-static int
-yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
-                yy_state_t *yyssp, int yytoken)
-{
-  enum { YYERROR_VERBOSE_ARGS_MAXIMUM = 5 };
-  /* Internationalized format string. */
-  const char *yyformat = YY_NULLPTR;
-  /* Arguments of yyformat: reported tokens (one for the "unexpected",
-     one per "expected"). */
-  char const *yyarg[YYERROR_VERBOSE_ARGS_MAXIMUM];
-  /* Actual size of YYARG. */
-  int yycount = 0;
-  /* Cumulated lengths of YYARG.  */
-  YYPTRDIFF_T yysize = 0;
-
-  /* There are many possibilities here to consider:
-     - If this state is a consistent state with a default action, then
-       the only way this function was invoked is if the default action
-       is an error action.  In that case, don't check for expected
-       tokens because there are none.
-     - The only way there can be no lookahead present (in yychar) is if
-       this state is a consistent state with a default action.  Thus,
-       detecting the absence of a lookahead is sufficient to determine
-       that there is no unexpected or expected token to report.  In that
-       case, just report a simple "syntax error".
-     - Don't assume there isn't a lookahead just because this state is a
-       consistent state with a default action.  There might have been a
-       previous inconsistent state, consistent state with a non-default
-       action, or user semantic action that manipulated yychar.
-     - Of course, the expected token list depends on states to have
-       correct lookahead information, and it depends on the parser not
-       to perform extra reductions after fetching a lookahead from the
-       scanner and before detecting a syntax error.  Thus, state merging
-       (from LALR or IELR) and default reductions corrupt the expected
-       token list.  However, the list is correct for canonical LR with
-       one exception: it will still contain any token that will not be
-       accepted due to an error action in a later state.
-  */
-  if (yytoken != YYEMPTY)
-    {
-      int yyn = yypact[+*yyssp];
-      YYPTRDIFF_T yysize0 = yytnamerr (YY_NULLPTR, yytname[yytoken]);
-      yysize = yysize0;
-      yyarg[yycount++] = yytname[yytoken];
-      if (!yypact_value_is_default (yyn))
-        {
-          /* Start YYX at -YYN if negative to avoid negative indexes in
-             YYCHECK.  In other words, skip the first -YYN actions for
-             this state because they are default actions.  */
-          int yyxbegin = yyn < 0 ? -yyn : 0;
-          /* Stay within bounds of both yycheck and yytname.  */
-          int yychecklim = YYLAST - yyn + 1;
-          int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
-          int yyx;
-
-          for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-            if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR
-                && !yytable_value_is_error (yytable[yyx + yyn]))
-              {
-                if (yycount == YYERROR_VERBOSE_ARGS_MAXIMUM)
-                  {
-                    yycount = 1;
-                    yysize = yysize0;
-                    break;
-                  }
-                yyarg[yycount++] = yytname[yyx];
-                {
-                  YYPTRDIFF_T yysize1
-                    = yysize + yytnamerr (YY_NULLPTR, yytname[yyx]);
-                  if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
-                    yysize = yysize1;
-                  else
-                    return 2;
-                }
-              }
-        }
-    }
-
-  switch (yycount)
-    {
-# define YYCASE_(N, S)                      \
-      case N:                               \
-        yyformat = S;                       \
-      break
-    default: /* Avoid compiler warnings. */
-      YYCASE_(0, YY_("syntax error"));
-      YYCASE_(1, YY_("syntax error, unexpected %s"));
-      YYCASE_(2, YY_("syntax error, unexpected %s, expecting %s"));
-      YYCASE_(3, YY_("syntax error, unexpected %s, expecting %s or %s"));
-      YYCASE_(4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
-      YYCASE_(5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
-# undef YYCASE_
-    }
 
-  {
-    /* Don't count the "%s"s in the final size, but reserve room for
-       the terminator.  */
-    YYPTRDIFF_T yysize1 = yysize + (yystrlen (yyformat) - 2 * yycount) + 1;
-    if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
-      yysize = yysize1;
-    else
-      return 2;
-  }
 
-  if (*yymsg_alloc < yysize)
-    {
-      *yymsg_alloc = 2 * yysize;
-      if (! (yysize <= *yymsg_alloc
-             && *yymsg_alloc <= YYSTACK_ALLOC_MAXIMUM))
-        *yymsg_alloc = YYSTACK_ALLOC_MAXIMUM;
-      return 1;
-    }
 
-  /* Avoid sprintf, as that infringes on the user's name space.
-     Don't have undefined behavior even if the translation
-     produced a string with the wrong number of "%s"s.  */
-  {
-    char *yyp = *yymsg;
-    int yyi = 0;
-    while ((*yyp = *yyformat) != '\0')
-      if (*yyp == '%' && yyformat[1] == 's' && yyi < yycount)
-        {
-          yyp += yytnamerr (yyp, yyarg[yyi++]);
-          yyformat += 2;
-        }
-      else
-        {
-          ++yyp;
-          ++yyformat;
-        }
-  }
-  return 0;
-}
-#endif /* YYERROR_VERBOSE */
 
 /*-----------------------------------------------.
 | Release the memory associated to this symbol.  |
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, yyscan_t scanner, _sf1_parse_args *results)
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, yyscan_t scanner, _sf1_parse_args *results)
 {
-  YYUSE (yyvaluep);
-  YYUSE (yylocationp);
-  YYUSE (scanner);
-  YYUSE (results);
+  YY_USE (yyvaluep);
+  YY_USE (yylocationp);
+  YY_USE (scanner);
+  YY_USE (results);
   if (!yymsg)
     yymsg = "Deleting";
-  YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
 
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  YYUSE (yytype);
+  switch (yykind)
+    {
+    case YYSYMBOL_SYLLABLE: /* SYLLABLE  */
+#line 59 "src/parser.y"
+            { _sf1_syllables_free(((*yyvaluep).SYLLABLE)); }
+#line 970 "src/derived-parser.c"
+        break;
+
+    case YYSYMBOL_SPLICE: /* SPLICE  */
+#line 59 "src/parser.y"
+            { _sf1_syllables_free(((*yyvaluep).SPLICE)); }
+#line 976 "src/derived-parser.c"
+        break;
+
+    case YYSYMBOL_cmds: /* cmds  */
+#line 60 "src/parser.y"
+            { _sf1_task_free(((*yyvaluep).cmds)); }
+#line 982 "src/derived-parser.c"
+        break;
+
+    case YYSYMBOL_cmd: /* cmd  */
+#line 60 "src/parser.y"
+            { _sf1_task_free(((*yyvaluep).cmd)); }
+#line 988 "src/derived-parser.c"
+        break;
+
+    case YYSYMBOL_redirects: /* redirects  */
+#line 61 "src/parser.y"
+            { _sf1_redirects_free(((*yyvaluep).redirects)); }
+#line 994 "src/derived-parser.c"
+        break;
+
+    case YYSYMBOL_redirect: /* redirect  */
+#line 61 "src/parser.y"
+            { _sf1_redirects_free(((*yyvaluep).redirect)); }
+#line 1000 "src/derived-parser.c"
+        break;
+
+    case YYSYMBOL_words: /* words  */
+#line 59 "src/parser.y"
+            { _sf1_syllables_free(((*yyvaluep).words)); }
+#line 1006 "src/derived-parser.c"
+        break;
+
+    case YYSYMBOL_syllables: /* syllables  */
+#line 59 "src/parser.y"
+            { _sf1_syllables_free(((*yyvaluep).syllables)); }
+#line 1012 "src/derived-parser.c"
+        break;
+
+      default:
+        break;
+    }
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
 
 
+
+
 /*----------.
 | yyparse.  |
 `----------*/
@@ -1226,7 +1029,7 @@ yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocatio
 int
 yyparse (yyscan_t scanner, _sf1_parse_args *results)
 {
-/* The lookahead symbol.  */
+/* Lookahead token kind.  */
 int yychar;
 
 
@@ -1245,55 +1048,47 @@ static YYLTYPE yyloc_default
 YYLTYPE yylloc = yyloc_default;
 
     /* Number of syntax errors so far.  */
-    int yynerrs;
+    int yynerrs = 0;
 
-    yy_state_fast_t yystate;
+    yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
-    int yyerrstatus;
+    int yyerrstatus = 0;
 
-    /* The stacks and their tools:
-       'yyss': related to states.
-       'yyvs': related to semantic values.
-       'yyls': related to locations.
-
-       Refer to the stacks through separate pointers, to allow yyoverflow
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
        to reallocate them elsewhere.  */
 
-    /* The state stack.  */
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
+
+    /* The state stack: array, bottom, top.  */
     yy_state_t yyssa[YYINITDEPTH];
-    yy_state_t *yyss;
-    yy_state_t *yyssp;
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
 
-    /* The semantic value stack.  */
+    /* The semantic value stack: array, bottom, top.  */
     YYSTYPE yyvsa[YYINITDEPTH];
-    YYSTYPE *yyvs;
-    YYSTYPE *yyvsp;
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
 
-    /* The location stack.  */
+    /* The location stack: array, bottom, top.  */
     YYLTYPE yylsa[YYINITDEPTH];
-    YYLTYPE *yyls;
-    YYLTYPE *yylsp;
-
-    /* The locations where the error started and ended.  */
-    YYLTYPE yyerror_range[3];
-
-    YYPTRDIFF_T yystacksize;
+    YYLTYPE *yyls = yylsa;
+    YYLTYPE *yylsp = yyls;
 
   int yyn;
+  /* The return value of yyparse.  */
   int yyresult;
-  /* Lookahead token as an internal (translated) token number.  */
-  int yytoken = 0;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
   /* The variables used to return semantic value and location from the
      action routines.  */
   YYSTYPE yyval;
   YYLTYPE yyloc;
 
-#if YYERROR_VERBOSE
-  /* Buffer for error messages, and its allocated size.  */
-  char yymsgbuf[128];
-  char *yymsg = yymsgbuf;
-  YYPTRDIFF_T yymsg_alloc = sizeof yymsgbuf;
-#endif
+  /* The locations where the error started and ended.  */
+  YYLTYPE yyerror_range[3];
+
+
 
 #define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N), yylsp -= (N))
 
@@ -1301,17 +1096,10 @@ YYLTYPE yylloc = yyloc_default;
      Keep to zero when no symbol should be popped.  */
   int yylen = 0;
 
-  yyssp = yyss = yyssa;
-  yyvsp = yyvs = yyvsa;
-  yylsp = yyls = yylsa;
-  yystacksize = YYINITDEPTH;
-
   YYDPRINTF ((stderr, "Starting parse\n"));
 
-  yystate = 0;
-  yyerrstatus = 0;
-  yynerrs = 0;
-  yychar = YYEMPTY; /* Cause a token to be read.  */
+  yychar = _SF1_YYEMPTY; /* Cause a token to be read.  */
+
   yylsp[0] = yylloc;
   goto yysetstate;
 
@@ -1334,10 +1122,11 @@ yysetstate:
   YY_IGNORE_USELESS_CAST_BEGIN
   *yyssp = YY_CAST (yy_state_t, yystate);
   YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
 
   if (yyss + yystacksize - 1 <= yyssp)
 #if !defined yyoverflow && !defined YYSTACK_RELOCATE
-    goto yyexhaustedlab;
+    YYNOMEM;
 #else
     {
       /* Get the current used size of the three stacks, in elements.  */
@@ -1368,7 +1157,7 @@ yysetstate:
 # else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-        goto yyexhaustedlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
         yystacksize = YYMAXDEPTH;
@@ -1379,11 +1168,11 @@ yysetstate:
           YY_CAST (union yyalloc *,
                    YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
         if (! yyptr)
-          goto yyexhaustedlab;
+          YYNOMEM;
         YYSTACK_RELOCATE (yyss_alloc, yyss);
         YYSTACK_RELOCATE (yyvs_alloc, yyvs);
         YYSTACK_RELOCATE (yyls_alloc, yyls);
-# undef YYSTACK_RELOCATE
+#  undef YYSTACK_RELOCATE
         if (yyss1 != yyssa)
           YYSTACK_FREE (yyss1);
       }
@@ -1403,6 +1192,7 @@ yysetstate:
     }
 #endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
+
   if (yystate == YYFINAL)
     YYACCEPT;
 
@@ -1423,18 +1213,30 @@ yybackup:
 
   /* Not known => get a lookahead token if don't already have one.  */
 
-  /* YYCHAR is either YYEMPTY or YYEOF or a valid lookahead symbol.  */
-  if (yychar == YYEMPTY)
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
+  if (yychar == _SF1_YYEMPTY)
     {
-      YYDPRINTF ((stderr, "Reading a token: "));
+      YYDPRINTF ((stderr, "Reading a token\n"));
       yychar = yylex (&yylval, &yylloc, scanner, results);
     }
 
-  if (yychar <= YYEOF)
+  if (yychar <= _SF1_YYEOF)
     {
-      yychar = yytoken = YYEOF;
+      yychar = _SF1_YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
       YYDPRINTF ((stderr, "Now at end of input.\n"));
     }
+  else if (yychar == _SF1_YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = _SF1_YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      yyerror_range[1] = yylloc;
+      goto yyerrlab1;
+    }
   else
     {
       yytoken = YYTRANSLATE (yychar);
@@ -1469,7 +1271,7 @@ yybackup:
   *++yylsp = yylloc;
 
   /* Discard the shifted token.  */
-  yychar = YYEMPTY;
+  yychar = _SF1_YYEMPTY;
   goto yynewstate;
 
 
@@ -1506,149 +1308,201 @@ yyreduce:
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-  case 2:
-#line 52 "src/parser.y"
-                               { results->tasks = (yyvsp[0].cmd); }
-#line 1513 "src/derived-parser.c"
+  case 2: /* top: cmds  */
+#line 66 "src/parser.y"
+                       { results->tasks = (yyvsp[0].cmds); }
+#line 1315 "src/derived-parser.c"
     break;
 
-  case 3:
-#line 53 "src/parser.y"
-                       { results->tasks = (yyvsp[-2].cmd); (yyvsp[-2].cmd)->next = (yyvsp[0].cmds); (yyvsp[0].cmds)->run_if = _SF1_RUN_ALWAYS; }
-#line 1519 "src/derived-parser.c"
+  case 3: /* cmds: cmd  */
+#line 69 "src/parser.y"
+                               { (yyval.cmds) = (yyvsp[0].cmd); }
+#line 1321 "src/derived-parser.c"
     break;
 
-  case 4:
-#line 54 "src/parser.y"
-                       { results->tasks = (yyvsp[-2].cmd); (yyvsp[-2].cmd)->next = (yyvsp[0].cmds); (yyvsp[0].cmds)->run_if = _SF1_RUN_IF_PREV_FAILED; }
-#line 1525 "src/derived-parser.c"
+  case 4: /* cmds: cmd SEMICOLON cmds  */
+#line 70 "src/parser.y"
+                       { (yyval.cmds) = (yyvsp[-2].cmd); (yyvsp[-2].cmd)->next = (yyvsp[0].cmds); (yyvsp[0].cmds)->run_if = _SF1_RUN_ALWAYS; }
+#line 1327 "src/derived-parser.c"
     break;
 
-  case 5:
-#line 55 "src/parser.y"
-                       { results->tasks = (yyvsp[-2].cmd); (yyvsp[-2].cmd)->next = (yyvsp[0].cmds); (yyvsp[0].cmds)->run_if = _SF1_RUN_IF_PREV_SUCCEEDED;  }
-#line 1531 "src/derived-parser.c"
+  case 5: /* cmds: cmd OR_OR cmds  */
+#line 71 "src/parser.y"
+                       { (yyval.cmds) = (yyvsp[-2].cmd); (yyvsp[-2].cmd)->next = (yyvsp[0].cmds); (yyvsp[0].cmds)->run_if = _SF1_RUN_IF_PREV_FAILED; }
+#line 1333 "src/derived-parser.c"
     break;
 
-  case 6:
-#line 56 "src/parser.y"
-                       { results->tasks = (yyvsp[-2].cmd); (yyvsp[-2].cmd)->next = (yyvsp[0].cmds); (yyvsp[0].cmds)->run_if = _SF1_RUN_ALWAYS; 
-                         _sf1_create_redirect_pipe((yyvsp[-2].cmd), (yyvsp[0].cmds)); }
-#line 1538 "src/derived-parser.c"
+  case 6: /* cmds: cmd AND_AND cmds  */
+#line 72 "src/parser.y"
+                       { (yyval.cmds) = (yyvsp[-2].cmd); (yyvsp[-2].cmd)->next = (yyvsp[0].cmds); (yyvsp[0].cmds)->run_if = _SF1_RUN_IF_PREV_SUCCEEDED;  }
+#line 1339 "src/derived-parser.c"
     break;
 
-  case 7:
-#line 60 "src/parser.y"
-                         { (yyval.cmd) = _sf1_create_cmd((yyvsp[-1].words), (yyvsp[0].redirects)); }
-#line 1544 "src/derived-parser.c"
+  case 7: /* cmds: cmd OR cmds  */
+#line 73 "src/parser.y"
+                       { (yyval.cmds) = (yyvsp[-2].cmd); (yyvsp[-2].cmd)->next = (yyvsp[0].cmds); (yyvsp[0].cmds)->run_if = _SF1_RUN_ALWAYS; 
+                         if (_sf1_create_redirect_pipe((yyvsp[-2].cmd), (yyvsp[0].cmds))) { _sf1_task_free((yyvsp[-2].cmd)); YYABORT; } }
+#line 1346 "src/derived-parser.c"
     break;
 
-  case 8:
-#line 63 "src/parser.y"
+  case 8: /* cmds: cmd OR_GREATER syllables OR cmds  */
+#line 75 "src/parser.y"
+                                            { (yyval.cmds) = _sf1_create_tee((yyvsp[-4].cmd), (yyvsp[-2].syllables), 0, (yyvsp[0].cmds)); if (!(yyval.cmds)) YYABORT; }
+#line 1352 "src/derived-parser.c"
+    break;
+
+  case 9: /* cmds: cmd OR_GREATER_GREATER syllables OR cmds  */
+#line 76 "src/parser.y"
+                                            { (yyval.cmds) = _sf1_create_tee((yyvsp[-4].cmd), (yyvsp[-2].syllables), 1, (yyvsp[0].cmds)); if (!(yyval.cmds)) YYABORT; }
+#line 1358 "src/derived-parser.c"
+    break;
+
+  case 10: /* cmd: words redirects  */
+#line 79 "src/parser.y"
+                         { (yyval.cmd) = _sf1_create_cmd((yyvsp[-1].words), (yyvsp[0].redirects)); if (!(yyval.cmd)) YYABORT; }
+#line 1364 "src/derived-parser.c"
+    break;
+
+  case 11: /* redirects: redirect redirects  */
+#line 82 "src/parser.y"
                          { (yyval.redirects) = _sf1_merge_redirects((yyvsp[-1].redirect), (yyvsp[0].redirects)); }
-#line 1550 "src/derived-parser.c"
+#line 1370 "src/derived-parser.c"
     break;
 
-  case 9:
-#line 64 "src/parser.y"
+  case 12: /* redirects: redirect  */
+#line 83 "src/parser.y"
                          { (yyval.redirects) = (yyvsp[0].redirect); }
-#line 1556 "src/derived-parser.c"
+#line 1376 "src/derived-parser.c"
     break;
 
-  case 10:
-#line 65 "src/parser.y"
+  case 13: /* redirects: %empty  */
+#line 84 "src/parser.y"
                          { (yyval.redirects) = NULL; }
-#line 1562 "src/derived-parser.c"
+#line 1382 "src/derived-parser.c"
     break;
 
-  case 11:
-#line 68 "src/parser.y"
-                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDIN,  _SF1_FILE,  0, (yyvsp[0].syllables)); }
-#line 1568 "src/derived-parser.c"
+  case 14: /* redirect: LESSER syllables  */
+#line 90 "src/parser.y"
+                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDIN,  _SF1_FILE,  0, (yyvsp[0].syllables)); if (!(yyval.redirect)) YYABORT; }
+#line 1388 "src/derived-parser.c"
     break;
 
-  case 12:
-#line 69 "src/parser.y"
-                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDOUT, _SF1_FILE,  0, (yyvsp[0].syllables)); }
-#line 1574 "src/derived-parser.c"
+  case 15: /* redirect: GREATER syllables  */
+#line 91 "src/parser.y"
+                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDOUT, _SF1_FILE,  0, (yyvsp[0].syllables)); if (!(yyval.redirect)) YYABORT; }
+#line 1394 "src/derived-parser.c"
     break;
 
-  case 13:
-#line 70 "src/parser.y"
-                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDOUT, _SF1_FILE,  1, (yyvsp[0].syllables)); }
-#line 1580 "src/derived-parser.c"
+  case 16: /* redirect: GREATER_GREATER syllables  */
+#line 92 "src/parser.y"
+                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDOUT, _SF1_FILE,  1, (yyvsp[0].syllables)); if (!(yyval.redirect)) YYABORT; }
+#line 1400 "src/derived-parser.c"
     break;
 
-  case 14:
-#line 71 "src/parser.y"
-                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDOUT, _SF1_SHARE, 0, NULL); }
-#line 1586 "src/derived-parser.c"
+  case 17: /* redirect: GREATER_AND_TWO  */
+#line 93 "src/parser.y"
+                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDOUT, _SF1_SHARE, 0, NULL); if (!(yyval.redirect)) YYABORT; }
+#line 1406 "src/derived-parser.c"
     break;
 
-  case 15:
-#line 72 "src/parser.y"
-                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDERR, _SF1_SHARE, 0, NULL); }
-#line 1592 "src/derived-parser.c"
+  case 18: /* redirect: TWO_GREATER_AND_ONE  */
+#line 94 "src/parser.y"
+                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDERR, _SF1_SHARE, 0, NULL); if (!(yyval.redirect)) YYABORT; }
+#line 1412 "src/derived-parser.c"
     break;
 
-  case 16:
-#line 73 "src/parser.y"
-                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDERR, _SF1_FILE,  0, (yyvsp[0].syllables)); }
-#line 1598 "src/derived-parser.c"
+  case 19: /* redirect: TWO_GREATER syllables  */
+#line 95 "src/parser.y"
+                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDERR, _SF1_FILE,  0, (yyvsp[0].syllables)); if (!(yyval.redirect)) YYABORT; }
+#line 1418 "src/derived-parser.c"
     break;
 
-  case 17:
-#line 74 "src/parser.y"
-                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDERR, _SF1_FILE,  1, (yyvsp[0].syllables)); }
-#line 1604 "src/derived-parser.c"
+  case 20: /* redirect: TWO_GREATER_GREATER syllables  */
+#line 96 "src/parser.y"
+                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDERR, _SF1_FILE,  1, (yyvsp[0].syllables)); if (!(yyval.redirect)) YYABORT; }
+#line 1424 "src/derived-parser.c"
     break;
 
-  case 18:
-#line 75 "src/parser.y"
-                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDERR, _SF1_SHARE, 0, NULL);
-                                (yyval.redirect)->next = _sf1_create_redirect(_SF1_STDOUT, _SF1_FILE,  0, (yyvsp[0].syllables)); }
-#line 1611 "src/derived-parser.c"
+  case 21: /* redirect: AND_GREATER syllables  */
+#line 97 "src/parser.y"
+                                    { (yyval.redirect) = _sf1_create_redirect_all(0, (yyvsp[0].syllables), -1); if (!(yyval.redirect)) YYABORT; }
+#line 1430 "src/derived-parser.c"
+    break;
+
+  case 22: /* redirect: AND_GREATER_GREATER syllables  */
+#line 98 "src/parser.y"
+                                    { (yyval.redirect) = _sf1_create_redirect_all(1, (yyvsp[0].syllables), -1); if (!(yyval.redirect)) YYABORT; }
+#line 1436 "src/derived-parser.c"
     break;
 
-  case 19:
-#line 77 "src/parser.y"
-                                    { (yyval.redirect) = _sf1_create_redirect(_SF1_STDERR, _SF1_SHARE, 1, NULL);
-                                (yyval.redirect)->next = _sf1_create_redirect(_SF1_STDOUT, _SF1_FILE,  1, (yyvsp[0].syllables)); }
-#line 1618 "src/derived-parser.c"
+  case 23: /* redirect: LESSER FD  */
+#line 99 "src/parser.y"
+                                    { (yyval.redirect) = _sf1_create_redirect_fd(_SF1_STDIN,  (yyvsp[0].FD)); if (!(yyval.redirect)) YYABORT; }
+#line 1442 "src/derived-parser.c"
     break;
 
-  case 20:
-#line 81 "src/parser.y"
+  case 24: /* redirect: GREATER FD  */
+#line 100 "src/parser.y"
+                                    { (yyval.redirect) = _sf1_create_redirect_fd(_SF1_STDOUT, (yyvsp[0].FD)); if (!(yyval.redirect)) YYABORT; }
+#line 1448 "src/derived-parser.c"
+    break;
+
+  case 25: /* redirect: TWO_GREATER FD  */
+#line 101 "src/parser.y"
+                                    { (yyval.redirect) = _sf1_create_redirect_fd(_SF1_STDERR, (yyvsp[0].FD)); if (!(yyval.redirect)) YYABORT; }
+#line 1454 "src/derived-parser.c"
+    break;
+
+  case 26: /* redirect: AND_GREATER FD  */
+#line 102 "src/parser.y"
+                                    { (yyval.redirect) = _sf1_create_redirect_all(0, NULL, (yyvsp[0].FD)); if (!(yyval.redirect)) YYABORT; }
+#line 1460 "src/derived-parser.c"
+    break;
+
+  case 27: /* words: syllables  */
+#line 105 "src/parser.y"
                          { (yyval.words) = (yyvsp[0].syllables); }
-#line 1624 "src/derived-parser.c"
+#line 1466 "src/derived-parser.c"
     break;
 
-  case 21:
-#line 82 "src/parser.y"
+  case 28: /* words: syllables SPACE words  */
+#line 106 "src/parser.y"
                          { (yyvsp[-2].syllables)->next_word = (yyvsp[0].words); (yyval.words) = (yyvsp[-2].syllables); }
-#line 1630 "src/derived-parser.c"
+#line 1472 "src/derived-parser.c"
     break;
 
-  case 22:
-#line 83 "src/parser.y"
-                         { YYABORT; }
-#line 1636 "src/derived-parser.c"
+  case 29: /* words: SPLICE  */
+#line 107 "src/parser.y"
+                         { (yyval.words) = (yyvsp[0].SPLICE); }
+#line 1478 "src/derived-parser.c"
     break;
 
-  case 23:
-#line 86 "src/parser.y"
+  case 30: /* words: SPLICE SPACE words  */
+#line 108 "src/parser.y"
+                         { (yyvsp[-2].SPLICE)->next_word = (yyvsp[0].words); (yyval.words) = (yyvsp[-2].SPLICE); }
+#line 1484 "src/derived-parser.c"
+    break;
+
+  case 31: /* words: error  */
+#line 109 "src/parser.y"
+                         { (yyval.words) = NULL; YYABORT; }
+#line 1490 "src/derived-parser.c"
+    break;
+
+  case 32: /* syllables: SYLLABLE  */
+#line 112 "src/parser.y"
                              { (yyval.syllables) = (yyvsp[0].SYLLABLE); }
-#line 1642 "src/derived-parser.c"
+#line 1496 "src/derived-parser.c"
     break;
 
-  case 24:
-#line 87 "src/parser.y"
+  case 33: /* syllables: SYLLABLE syllables  */
+#line 113 "src/parser.y"
                          { (yyvsp[-1].SYLLABLE)->next = (yyvsp[0].syllables); (yyval.syllables) = (yyvsp[-1].SYLLABLE); }
-#line 1648 "src/derived-parser.c"
+#line 1502 "src/derived-parser.c"
     break;
 
 
-#line 1652 "src/derived-parser.c"
+#line 1506 "src/derived-parser.c"
 
       default: break;
     }
@@ -1663,11 +1517,10 @@ yyreduce:
      case of YYERROR or YYBACKUP, subsequent parser actions might lead
      to an incorrect destructor call or verbose syntax error message
      before the lookahead is translated.  */
-  YY_SYMBOL_PRINT ("-> $$ =", yyr1[yyn], &yyval, &yyloc);
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
 
   YYPOPSTACK (yylen);
   yylen = 0;
-  YY_STACK_PRINT (yyss, yyssp);
 
   *++yyvsp = yyval;
   *++yylsp = yyloc;
@@ -1692,66 +1545,31 @@ yyreduce:
 yyerrlab:
   /* Make sure we have latest lookahead translation.  See comments at
      user semantic actions for why this is necessary.  */
-  yytoken = yychar == YYEMPTY ? YYEMPTY : YYTRANSLATE (yychar);
-
+  yytoken = yychar == _SF1_YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
   /* If not already recovering from an error, report this error.  */
   if (!yyerrstatus)
     {
       ++yynerrs;
-#if ! YYERROR_VERBOSE
       yyerror (&yylloc, scanner, results, YY_("syntax error"));
-#else
-# define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
-                                        yyssp, yytoken)
-      {
-        char const *yymsgp = YY_("syntax error");
-        int yysyntax_error_status;
-        yysyntax_error_status = YYSYNTAX_ERROR;
-        if (yysyntax_error_status == 0)
-          yymsgp = yymsg;
-        else if (yysyntax_error_status == 1)
-          {
-            if (yymsg != yymsgbuf)
-              YYSTACK_FREE (yymsg);
-            yymsg = YY_CAST (char *, YYSTACK_ALLOC (YY_CAST (YYSIZE_T, yymsg_alloc)));
-            if (!yymsg)
-              {
-                yymsg = yymsgbuf;
-                yymsg_alloc = sizeof yymsgbuf;
-                yysyntax_error_status = 2;
-              }
-            else
-              {
-                yysyntax_error_status = YYSYNTAX_ERROR;
-                yymsgp = yymsg;
-              }
-          }
-        yyerror (&yylloc, scanner, results, yymsgp);
-        if (yysyntax_error_status == 2)
-          goto yyexhaustedlab;
-      }
-# undef YYSYNTAX_ERROR
-#endif
     }
 
   yyerror_range[1] = yylloc;
-
   if (yyerrstatus == 3)
     {
       /* If just tried and failed to reuse lookahead token after an
          error, discard it.  */
 
-      if (yychar <= YYEOF)
+      if (yychar <= _SF1_YYEOF)
         {
           /* Return failure if at end of input.  */
-          if (yychar == YYEOF)
+          if (yychar == _SF1_YYEOF)
             YYABORT;
         }
       else
         {
           yydestruct ("Error: discarding",
                       yytoken, &yylval, &yylloc, scanner, results);
-          yychar = YYEMPTY;
+          yychar = _SF1_YYEMPTY;
         }
     }
 
@@ -1768,6 +1586,7 @@ yyerrorlab:
      label yyerrorlab therefore never appears in user code.  */
   if (0)
     YYERROR;
+  ++yynerrs;
 
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYERROR.  */
@@ -1784,13 +1603,14 @@ yyerrorlab:
 yyerrlab1:
   yyerrstatus = 3;      /* Each real token shifted decrements this.  */
 
+  /* Pop stack until we find a state that shifts the error token.  */
   for (;;)
     {
       yyn = yypact[yystate];
       if (!yypact_value_is_default (yyn))
         {
-          yyn += YYTERROR;
-          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYTERROR)
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
             {
               yyn = yytable[yyn];
               if (0 < yyn)
@@ -1804,7 +1624,7 @@ yyerrlab1:
 
       yyerror_range[1] = *yylsp;
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp, yylsp, scanner, results);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, yylsp, scanner, results);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1815,13 +1635,11 @@ yyerrlab1:
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 
   yyerror_range[2] = yylloc;
-  /* Using YYLLOC is tempting, but would change the location of
-     the lookahead.  YYLOC is available though.  */
-  YYLLOC_DEFAULT (yyloc, yyerror_range, 2);
-  *++yylsp = yyloc;
+  ++yylsp;
+  YYLLOC_DEFAULT (*yylsp, yyerror_range, 2);
 
   /* Shift the error token.  */
-  YY_SYMBOL_PRINT ("Shifting", yystos[yyn], yyvsp, yylsp);
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
 
   yystate = yyn;
   goto yynewstate;
@@ -1832,7 +1650,7 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
 
 
 /*-----------------------------------.
@@ -1840,25 +1658,23 @@ yyacceptlab:
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
 
 
-#if !defined yyoverflow || YYERROR_VERBOSE
-/*-------------------------------------------------.
-| yyexhaustedlab -- memory exhaustion comes here.  |
-`-------------------------------------------------*/
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
 yyexhaustedlab:
   yyerror (&yylloc, scanner, results, YY_("memory exhausted"));
   yyresult = 2;
-  /* Fall through.  */
-#endif
+  goto yyreturnlab;
 
 
-/*-----------------------------------------------------.
-| yyreturn -- parsing is finished, return the result.  |
-`-----------------------------------------------------*/
-yyreturn:
-  if (yychar != YYEMPTY)
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
+  if (yychar != _SF1_YYEMPTY)
     {
       /* Make sure we have latest lookahead translation.  See comments at
          user semantic actions for why this is necessary.  */
@@ -1873,19 +1689,17 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[+*yyssp], yyvsp, yylsp, scanner, results);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, yylsp, scanner, results);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
-#if YYERROR_VERBOSE
-  if (yymsg != yymsgbuf)
-    YYSTACK_FREE (yymsg);
-#endif
+
   return yyresult;
 }
-#line 90 "src/parser.y"
+
+#line 116 "src/parser.y"
 
 
@@ -1,8 +1,8 @@
-/* A Bison parser, made by GNU Bison 3.5.1.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison interface for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2020 Free Software Foundation,
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
    Inc.
 
    This program is free software: you can redistribute it and/or modify
@@ -16,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -31,8 +31,9 @@
    This special exception was added by the Free Software Foundation in
    version 2.2 of Bison.  */
 
-/* Undocumented macros, especially those whose name start with YY_,
-   are private implementation details.  Do not rely on them.  */
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
 
 #ifndef YY__SF1_YY_SRC_DERIVED_PARSER_H_INCLUDED
 # define YY__SF1_YY_SRC_DERIVED_PARSER_H_INCLUDED
@@ -63,52 +64,57 @@ extern int _sf1_yydebug;
     #include "systemf-internal.h"
 
 
-#line 67 "src/derived-parser.h"
+#line 68 "src/derived-parser.h"
 
-/* Token type.  */
+/* Token kinds.  */
 #ifndef _SF1_YYTOKENTYPE
 # define _SF1_YYTOKENTYPE
   enum _sf1_yytokentype
   {
-    SYLLABLE = 258,
-    SPACE = 259,
-    QUOTE = 260,
-    LESSER = 261,
-    TWO_GREATER_AND_ONE = 262,
-    TWO_GREATER = 263,
-    AND_GREATER = 264,
-    GREATER = 265,
-    TWO_GREATER_GREATER = 266,
-    AND_GREATER_GREATER = 267,
-    GREATER_GREATER = 268,
-    GREATER_AND_TWO = 269,
-    AND_AND = 270,
-    OR_OR = 271,
-    SEMICOLON = 272,
-    OR = 273
+    _SF1_YYEMPTY = -2,
+    _SF1_YYEOF = 0,                /* "end of file"  */
+    _SF1_YYerror = 256,            /* error  */
+    _SF1_YYUNDEF = 257,            /* "invalid token"  */
+    SYLLABLE = 258,                /* SYLLABLE  */
+    SPLICE = 259,                  /* SPLICE  */
+    FD = 260,                      /* FD  */
+    BAD_ARG = 261,                 /* BAD_ARG  */
+    SPACE = 262,                   /* SPACE  */
+    QUOTE = 263,                   /* QUOTE  */
+    LESSER = 264,                  /* LESSER  */
+    TWO_GREATER_AND_ONE = 265,     /* TWO_GREATER_AND_ONE  */
+    TWO_GREATER = 266,             /* TWO_GREATER  */
+    AND_GREATER = 267,             /* AND_GREATER  */
+    GREATER = 268,                 /* GREATER  */
+    TWO_GREATER_GREATER = 269,     /* TWO_GREATER_GREATER  */
+    AND_GREATER_GREATER = 270,     /* AND_GREATER_GREATER  */
+    GREATER_GREATER = 271,         /* GREATER_GREATER  */
+    GREATER_AND_TWO = 272,         /* GREATER_AND_TWO  */
+    AND_AND = 273,                 /* AND_AND  */
+    OR_OR = 274,                   /* OR_OR  */
+    SEMICOLON = 275,               /* SEMICOLON  */
+    OR = 276,                      /* OR  */
+    OR_GREATER = 277,              /* OR_GREATER  */
+    OR_GREATER_GREATER = 278       /* OR_GREATER_GREATER  */
   };
+  typedef enum _sf1_yytokentype _sf1_yytoken_kind_t;
 #endif
 
 /* Value type.  */
 #if ! defined _SF1_YYSTYPE && ! defined _SF1_YYSTYPE_IS_DECLARED
 union _SF1_YYSTYPE
 {
-
-  /* redirects  */
-  _sf1_redirect * redirects;
-  /* redirect  */
-  _sf1_redirect * redirect;
-  /* SYLLABLE  */
-  _sf1_syllable * SYLLABLE;
-  /* words  */
-  _sf1_syllable * words;
-  /* syllables  */
-  _sf1_syllable * syllables;
-  /* cmds  */
-  _sf1_task * cmds;
-  /* cmd  */
-  _sf1_task * cmd;
-#line 112 "src/derived-parser.h"
+  _sf1_redirect * redirects;               /* redirects  */
+  _sf1_redirect * redirect;                /* redirect  */
+  _sf1_syllable * SYLLABLE;                /* SYLLABLE  */
+  _sf1_syllable * SPLICE;                  /* SPLICE  */
+  _sf1_syllable * words;                   /* words  */
+  _sf1_syllable * syllables;               /* syllables  */
+  _sf1_task * cmds;                        /* cmds  */
+  _sf1_task * cmd;                         /* cmd  */
+  int FD;                                  /* FD  */
+
+#line 118 "src/derived-parser.h"
 
 };
 typedef union _SF1_YYSTYPE _SF1_YYSTYPE;
@@ -132,7 +138,9 @@ struct _SF1_YYLTYPE
 
 
 
+
 int _sf1_yyparse (yyscan_t scanner, _sf1_parse_args *results);
+
 /* "%code provides" blocks.  */
 #line 25 "src/parser.y"
 
@@ -143,6 +151,6 @@ int _sf1_yyparse (yyscan_t scanner, _sf1_parse_args *results);
 
     int _sf1_yyerror(_SF1_YYLTYPE *locp, yyscan_t scanner, _sf1_parse_args *results, const char *msg);
 
-#line 147 "src/derived-parser.h"
+#line 155 "src/derived-parser.h"
 
 #endif /* !YY__SF1_YY_SRC_DERIVED_PARSER_H_INCLUDED  */
@@ -0,0 +1,262 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "systemf-internal.h"
+
+extern char **environ;
+
+#define ENV_CACHE_SIZE 8
+
+/*
+ * A merged environment.  It is cached keyed on the base it was built from and
+ * the overrides applied to it, so calls with the same overrides share it.
+ * The base is remembered by its array of pointers, which setenv() and
+ * putenv() change when they change the environment.
+ */
+struct _sf1_env_ {
+    struct _sf1_env_ *next; // Most recently used first.
+    int refs;               // One for the cache plus one per run using envp.
+    char *const *base;
+    size_t base_count;
+    char **base_snapshot;
+    char **set;
+    char **unset;
+    char **envp;            // The strings are in the same allocation.
+};
+
+static pthread_mutex_t env_lock = PTHREAD_MUTEX_INITIALIZER;
+static _sf1_env *env_cache = NULL;
+
+static size_t strv_count(const char *const *strv) {
+    size_t count = 0;
+
+    while (strv && strv[count]) {
+        count++;
+    }
+    return count;
+}
+
+static int strv_equal(char *const *left, const char *const *right) {
+    size_t i;
+
+    for (i = 0; left[i] && right && right[i]; i++) {
+        if (strcmp(left[i], right[i])) {
+            return 0;
+        }
+    }
+    return !left[i] && !(right && right[i]);
+}
+
+/*
+ * Copies strv into a single allocation.  A NULL strv is copied as empty.
+ */
+static char **strv_dup(const char *const *strv) {
+    size_t count = strv_count(strv);
+    size_t size = (count + 1) * sizeof(char *);
+    char **copy;
+    char *cursor;
+
+    for (size_t i = 0; i < count; i++) {
+        size += strlen(strv[i]) + 1;
+    }
+    copy = _sf1_malloc(size);
+    if (!copy) {
+        return NULL;
+    }
+    cursor = (char *) (copy + count + 1);
+    for (size_t i = 0; i < count; i++) {
+        copy[i] = cursor;
+        cursor = stpcpy(cursor, strv[i]) + 1;
+    }
+    copy[count] = NULL;
+    return copy;
+}
+
+/*
+ * Returns 1 if entry ("NAME=value") is for name.  name may be followed by
+ * "=value" itself.
+ */
+static int env_name_is(const char *entry, const char *name) {
+    size_t len = strcspn(name, "=");
+    return !strncmp(entry, name, len) && (entry[len] == '=');
+}
+
+static int env_is_overridden(const char *entry, char *const *set, char *const *unset) {
+    for (; *set; set++) {
+        if (env_name_is(entry, *set)) {
+            return 1;
+        }
+    }
+    for (; *unset; unset++) {
+        if (env_name_is(entry, *unset)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void env_free(_sf1_env *env) {
+    if (env) {
+        _sf1_free(env->base_snapshot);
+        _sf1_free(env->set);
+        _sf1_free(env->unset);
+        _sf1_free(env->envp);
+        _sf1_free(env);
+    }
+}
+
+static int env_matches(_sf1_env *env, char *const *base, size_t base_count,
+                       const char *const *set, const char *const *unset) {
+    return (env->base == base) && (env->base_count == base_count) &&
+        !memcmp(env->base_snapshot, base, base_count * sizeof(char *)) &&
+        strv_equal(env->set, set) && strv_equal(env->unset, unset);
+}
+
+/*
+ * Builds base with the entries of set added or replaced and the names in unset removed.
+ */
+static _sf1_env *env_build(char *const *base, size_t base_count,
+                           const char *const *set, const char *const *unset) {
+    _sf1_env *env = _sf1_calloc(1, sizeof(*env));
+    size_t count = 0;
+    size_t size;
+    char *cursor;
+
+    if (!env) {
+        return NULL;
+    }
+    env->base = base;
+    env->base_count = base_count;
+    env->base_snapshot = _sf1_malloc((base_count + 1) * sizeof(char *));
+    env->set = strv_dup(set);
+    env->unset = strv_dup(unset);
+    if (!env->base_snapshot || !env->set || !env->unset) {
+        env_free(env);
+        return NULL;
+    }
+    memcpy(env->base_snapshot, base, base_count * sizeof(char *));
+
+    size = sizeof(char *);
+    for (size_t i = 0; i < base_count; i++) {
+        if (!env_is_overridden(base[i], env->set, env->unset)) {
+            size += sizeof(char *) + strlen(base[i]) + 1;
+            count++;
+        }
+    }
+    for (char **s = env->set; *s; s++) {
+        size += sizeof(char *) + strlen(*s) + 1;
+        count++;
+    }
+
+    env->envp = _sf1_malloc(size);
+    if (!env->envp) {
+        env_free(env);
+        return NULL;
+    }
+    cursor = (char *) (env->envp + count + 1);
+    count = 0;
+    for (size_t i = 0; i < base_count; i++) {
+        if (!env_is_overridden(base[i], env->set, env->unset)) {
+            env->envp[count++] = cursor;
+            cursor = stpcpy(cursor, base[i]) + 1;
+        }
+    }
+    for (char **s = env->set; *s; s++) {
+        env->envp[count++] = cursor;
+        cursor = stpcpy(cursor, *s) + 1;
+    }
+    env->envp[count] = NULL;
+
+    return env;
+}
+
+/*
+ * Returns the environment for a run with opts.  If *env is set on return,
+ * it must be given back with _sf1_env_release() once the run is done.
+ * Returns NULL with errno set on failure.
+ */
+char *const *_sf1_env_acquire(const systemf1_opts *opts, _sf1_env **env) {
+    char *const *base = (opts && opts->envp) ? opts->envp : environ;
+    const char *const *set = opts ? opts->env_set : NULL;
+    const char *const *unset = opts ? opts->env_unset : NULL;
+    _sf1_env **pp;
+    _sf1_env *found;
+    size_t base_count;
+    int cached = 0;
+
+    *env = NULL;
+    if (!strv_count(set) && !strv_count(unset)) {
+        return base;
+    }
+    for (const char *const *s = set; s && *s; s++) {
+        if (!strchr(*s, '=')) {
+            errno = EINVAL;
+            return NULL;
+        }
+    }
+    base_count = strv_count((const char *const *) base);
+
+    pthread_mutex_lock(&env_lock);
+    for (pp = &env_cache; *pp; pp = &(*pp)->next, cached++) {
+        if (env_matches(*pp, base, base_count, set, unset)) {
+            break;
+        }
+    }
+    found = *pp;
+    if (found) {
+        // Move it to the front.
+        *pp = found->next;
+    } else {
+        found = env_build(base, base_count, set, unset);
+        if (!found) {
+            pthread_mutex_unlock(&env_lock);
+            return NULL;
+        }
+        found->refs = 1;
+        if (cached >= ENV_CACHE_SIZE) {
+            // Drop the least recently used.
+            for (pp = &env_cache; (*pp)->next; pp = &(*pp)->next);
+            if (--(*pp)->refs == 0) {
+                env_free(*pp);
+            }
+            *pp = NULL;
+        }
+    }
+    found->next = env_cache;
+    env_cache = found;
+    found->refs++;
+    pthread_mutex_unlock(&env_lock);
+
+    *env = found;
+    return found->envp;
+}
+
+/*
+ * Drops every cached environment.  Ones still used by a run are freed when it
+ * releases them.
+ */
+void _sf1_env_cache_flush(void) {
+    pthread_mutex_lock(&env_lock);
+    while (env_cache) {
+        _sf1_env *env = env_cache;
+
+        env_cache = env->next;
+        if (--env->refs == 0) {
+            env_free(env);
+        }
+    }
+    pthread_mutex_unlock(&env_lock);
+}
+
+void _sf1_env_release(_sf1_env *env) {
+    if (!env) {
+        return;
+    }
+    pthread_mutex_lock(&env_lock);
+    if (--env->refs == 0) {
+        env_free(env);
+    }
+    pthread_mutex_unlock(&env_lock);
+}
@@ -4,6 +4,9 @@
 #include <assert.h>
 #include <errno.h>
 
+#include "systemf-internal.h"
+#include "probes.h"
+
 /*
  * The dir structure is used in walking directories.  For these two cases,
  * these map to directory tuples: {start, end, depth}:
@@ -131,7 +134,7 @@ static char *extract_simplified_path(char *path) {
     struct dir simple_dir;
     struct dir cursor;
 
-    simple_path = malloc(strlen(path)+1);
+    simple_path = _sf1_malloc(strlen(path)+1);
     if (!simple_path) {
         return NULL;
     }
@@ -198,8 +201,8 @@ static int complex_sandbox_check(char *trusted_path, char *path) {
     } else {
         retval = ENOMEM;
     }
-    free(tp);
-    free(p);
+    _sf1_free(tp);
+    _sf1_free(p);
 
     return retval;
 }
@@ -220,6 +223,7 @@ int _sf1_file_sandbox_check(char *trusted_path, char *path) {
         retval = complex_sandbox_check(trusted_path, path);
     }
 
+    _SF1_PROBE(sandbox, trusted_path, path, retval);
     if (retval) {
         fprintf(stderr, "systemf: %s: sandboxing %s\n", strerror(retval), path);
     }
@@ -0,0 +1,479 @@
+#define _GNU_SOURCE // O_PATH.
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include "systemf-internal.h"
+
+#if defined(__linux__) && defined(SYS_pidfd_open)
+#define HAVE_PIDFD 1
+#else
+#define HAVE_PIDFD 0
+#endif
+
+/*
+ * The forkserver is a helper forked by systemf1_forkserver_start() that forks
+ * the children in place of the caller.  The caller sends it requests over a
+ * Unix socket and waits for each reply, one request at a time.
+ *
+ * A spawn request is followed by the rlimits, the cpu affinity, and then the
+ * argv and envp strings, each NUL terminated.  It carries the in, out, err, and
+ * working directory fds of the child and the cgroup fd when there is one.
+ */
+enum {
+    FORKSERVER_SPAWN,
+    FORKSERVER_REAP,
+};
+
+#define FORKSERVER_FDS 5
+
+typedef struct {
+    int op;
+    pid_t pid;                // Reap: the child.
+    int options;              // Reap: for waitpid().
+    int has_cgroup;
+    int has_limits;
+    int argc;
+    int envc;
+    int nice;
+    int ioprio;
+    size_t strings_size;
+    size_t rlimit_count;
+    size_t cpu_affinity_size;
+} forkserver_request;
+
+typedef struct {
+    pid_t pid;                // -1 on failure.
+    int stat;
+    int err;                  // errno on failure.
+} forkserver_reply;
+
+int _sf1_forkserver_fd = -1;
+static pid_t forkserver_pid = -1;
+static pthread_mutex_t forkserver_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int write_all(int fd, const void *buf, size_t size) {
+    const char *p = buf;
+
+    while (size) {
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        size -= n;
+    }
+    return 0;
+}
+
+static int read_all(int fd, void *buf, size_t size) {
+    char *p = buf;
+
+    while (size) {
+        ssize_t n = read(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            errno = EPIPE;
+            return -1;
+        }
+        p += n;
+        size -= n;
+    }
+    return 0;
+}
+
+/*
+ * Sends req with nfds fds attached, then size bytes of payload, and reads the
+ * reply.  Returns -1 if the helper can't be reached.
+ */
+static int forkserver_call(const forkserver_request *req, const int *fds, int nfds, const void *payload,
+                           size_t size, forkserver_reply *reply) {
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * FORKSERVER_FDS)];
+        struct cmsghdr align;
+    } control;
+    struct iovec iov = { .iov_base = (void *)req, .iov_len = sizeof(*req) };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+    int sock = __atomic_load_n(&_sf1_forkserver_fd, __ATOMIC_ACQUIRE);
+    int ret = -1;
+    ssize_t n;
+
+    if (nfds) {
+        struct cmsghdr *cmsg;
+
+        memset(&control, 0, sizeof(control));
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * nfds);
+        cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * nfds);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * nfds);
+    }
+
+    pthread_mutex_lock(&forkserver_lock);
+    while (((n = sendmsg(sock, &msg, MSG_NOSIGNAL)) < 0) && (errno == EINTR));
+    // The fds went with the first byte.  The rest of a stream may be sent in parts.
+    if ((n >= 0) &&
+        !write_all(sock, (const char *)req + n, sizeof(*req) - n) &&
+        !write_all(sock, payload, size) &&
+        !read_all(sock, reply, sizeof(*reply))) {
+        ret = 0;
+    }
+    pthread_mutex_unlock(&forkserver_lock);
+    if (ret) {
+        fprintf(stderr, "systemf: %s talking to the forkserver\n", strerror(errno));
+    }
+    return ret;
+}
+
+/*
+ * Has the helper fork spawn->argv.  Returns the pid or -1 with errno set.
+ */
+pid_t _sf1_forkserver_spawn(const _sf1_spawn *spawn) {
+    forkserver_request req = { .op = FORKSERVER_SPAWN };
+    forkserver_reply reply;
+    const systemf1_opts *limits = spawn->limits;
+    int fds[FORKSERVER_FDS] = { spawn->in, spawn->out, spawn->err, spawn->dirfd, spawn->cgroup_fd };
+    int cwd = -1;
+    size_t rlimits_size;
+    char *payload;
+    char *p;
+
+    if (spawn->dirfd == AT_FDCWD) {
+        // The helper is still in the directory it started in.
+        cwd = open(".", O_PATH | O_DIRECTORY | O_CLOEXEC);
+        if (cwd < 0) {
+            return -1;
+        }
+        fds[3] = cwd;
+    }
+    req.has_cgroup = (spawn->cgroup_fd >= 0);
+
+    for (char *const *arg = spawn->argv; *arg; arg++) {
+        req.argc++;
+        req.strings_size += strlen(*arg) + 1;
+    }
+    for (char *const *env = spawn->envp; *env; env++) {
+        req.envc++;
+        req.strings_size += strlen(*env) + 1;
+    }
+    if (limits) {
+        req.has_limits = 1;
+        req.nice = limits->nice;
+        req.ioprio = limits->ioprio;
+        req.rlimit_count = limits->rlimit_count;
+        req.cpu_affinity_size = limits->cpu_affinity ? limits->cpu_affinity_size : 0;
+    }
+    rlimits_size = sizeof(systemf1_rlimit) * req.rlimit_count;
+
+    payload = _sf1_malloc(req.strings_size + rlimits_size + req.cpu_affinity_size + 1);
+    if (!payload) {
+        if (cwd >= 0) {
+            close(cwd);
+        }
+        return -1;
+    }
+    p = payload;
+    if (rlimits_size) {
+        memcpy(p, limits->rlimits, rlimits_size);
+        p += rlimits_size;
+    }
+    if (req.cpu_affinity_size) {
+        memcpy(p, limits->cpu_affinity, req.cpu_affinity_size);
+        p += req.cpu_affinity_size;
+    }
+    for (char *const *arg = spawn->argv; *arg; arg++) {
+        p = stpcpy(p, *arg) + 1;
+    }
+    for (char *const *env = spawn->envp; *env; env++) {
+        p = stpcpy(p, *env) + 1;
+    }
+
+    if (forkserver_call(&req, fds, 4 + req.has_cgroup, payload, p - payload, &reply)) {
+        reply.pid = -1;
+        reply.err = errno;
+    }
+    _sf1_free(payload);
+    if (cwd >= 0) {
+        close(cwd);
+    }
+    if (reply.pid < 0) {
+        errno = reply.err;
+    }
+    return reply.pid;
+}
+
+/*
+ * waitpid() for the pids of a run.  The children are the helper's while it runs.
+ */
+pid_t _sf1_waitpid(pid_t pid, int *stat, int options) {
+    forkserver_request req = { .op = FORKSERVER_REAP, .pid = pid, .options = options };
+    forkserver_reply reply;
+
+    if (_sf1_builtin_is(pid)) {
+        return _sf1_builtin_wait(pid, stat, options);
+    }
+    if (!_sf1_forkserver_running()) {
+        return waitpid(pid, stat, options);
+    }
+#if HAVE_PIDFD
+    // Blocking in the helper would hold up every other thread's requests, so
+    // only ask once the child has exited.
+    if (!(options & WNOHANG)) {
+        int pidfd = syscall(SYS_pidfd_open, pid, 0);
+
+        if (pidfd >= 0) {
+            struct pollfd pfd = { .fd = pidfd, .events = POLLIN };
+
+            while ((poll(&pfd, 1, -1) < 0) && (errno == EINTR));
+            close(pidfd);
+        }
+    }
+#endif
+    if (forkserver_call(&req, NULL, 0, NULL, 0, &reply)) {
+        return -1;
+    }
+    if (reply.pid < 0) {
+        errno = reply.err;
+    } else if (stat) {
+        *stat = reply.stat;
+    }
+    return reply.pid;
+}
+
+#if HAVE_PIDFD
+/*
+ * Reads a request and its fds.  Returns the number of fds or -1 once the
+ * caller has gone away.
+ */
+static int serve_read(int sock, forkserver_request *req, int *fds) {
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * FORKSERVER_FDS)];
+        struct cmsghdr align;
+    } control;
+    struct iovec iov = { .iov_base = req, .iov_len = sizeof(*req) };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1, .msg_control = control.buf,
+                          .msg_controllen = sizeof(control.buf) };
+    struct cmsghdr *cmsg;
+    int nfds = 0;
+    ssize_t n;
+
+    while (((n = recvmsg(sock, &msg, 0)) < 0) && (errno == EINTR));
+    if (n <= 0) {
+        return -1;
+    }
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS)) {
+            nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * nfds);
+        }
+    }
+    if (read_all(sock, (char *)req + n, sizeof(*req) - n)) {
+        return -1;
+    }
+    return nfds;
+}
+
+/*
+ * Splits count NUL terminated strings off the front of *p into vec.  Returns -1
+ * if they run past end.
+ */
+static int serve_strings(char **p, const char *end, char **vec, int count) {
+    for (int i = 0; i < count; i++) {
+        char *nul = memchr(*p, 0, end - *p);
+
+        if (!nul) {
+            return -1;
+        }
+        vec[i] = *p;
+        *p = nul + 1;
+    }
+    vec[count] = NULL;
+    return 0;
+}
+
+/*
+ * Reads the rest of a spawn request and forks the child.
+ */
+static pid_t serve_spawn(int sock, const forkserver_request *req, const int *fds, int nfds) {
+    size_t rlimits_size = sizeof(systemf1_rlimit) * req->rlimit_count;
+    size_t size = req->strings_size + rlimits_size + req->cpu_affinity_size;
+    // Plain malloc() rather than systemf1_set_allocator()'s.  The helper is a fork
+    // of the caller, and a pooled or per-thread allocator may not work in it.
+    char *payload = malloc(size + 1);
+    char **argv = malloc(sizeof(char *) * (req->argc + 1));
+    char **envp = malloc(sizeof(char *) * (req->envc + 1));
+    char *p = payload + rlimits_size + req->cpu_affinity_size;
+    systemf1_opts limits = {
+        .nice = req->nice,
+        .ioprio = req->ioprio,
+        .rlimit_count = req->rlimit_count,
+        .cpu_affinity_size = req->cpu_affinity_size,
+    };
+    _sf1_spawn spawn = {
+        .argv = argv,
+        .envp = envp,
+        .in = fds[0],
+        .out = fds[1],
+        .err = fds[2],
+        .dirfd = fds[3],
+        .cgroup_fd = req->has_cgroup ? fds[4] : -1,
+        .limits = req->has_limits ? &limits : NULL,
+    };
+    pid_t pid = -1;
+
+    if (!payload || !argv || !envp) {
+        // The payload still has to be read past.
+        for (char skip[256]; size; size -= (size < sizeof(skip)) ? size : sizeof(skip)) {
+            if (read_all(sock, skip, (size < sizeof(skip)) ? size : sizeof(skip))) {
+                break;
+            }
+        }
+        errno = ENOMEM;
+        goto exit;
+    }
+    if (read_all(sock, payload, size)) {
+        goto exit;
+    }
+    if ((nfds != 4 + req->has_cgroup) || (req->argc < 1) ||
+        serve_strings(&p, payload + size, argv, req->argc) ||
+        serve_strings(&p, payload + size, envp, req->envc)) {
+        errno = EINVAL;
+        goto exit;
+    }
+    limits.rlimits = (const systemf1_rlimit *)payload;
+    limits.cpu_affinity = req->cpu_affinity_size ? payload + rlimits_size : NULL;
+
+    pid = _sf1_child_spawn(&spawn);
+
+exit:
+    free(payload);
+    free(argv);
+    free(envp);
+    return pid;
+}
+
+/*
+ * The helper.  Serves requests until the caller closes its end of sock.
+ */
+static void serve(int sock) {
+    struct rlimit rlim;
+
+    // Only the socket and stdio are kept from the caller.  stdio is opened if
+    // the caller closed it so no fd that is sent lands on 0, 1, or 2.
+    getrlimit(RLIMIT_NOFILE, &rlim);
+    for (int fd = 3; fd < rlim.rlim_cur; fd++) {
+        if (fd != sock) {
+            close(fd);
+        }
+    }
+    for (int fd = 0; fd < 3; fd++) {
+        if (fcntl(fd, F_GETFD) < 0) {
+            int null = open("/dev/null", O_RDWR);
+
+            if ((null >= 0) && (null != fd)) {
+                dup2(null, fd);
+                close(null);
+            }
+        }
+    }
+
+    for (;;) {
+        forkserver_request req;
+        forkserver_reply reply = { .pid = -1 };
+        int fds[FORKSERVER_FDS];
+        int nfds = serve_read(sock, &req, fds);
+
+        if (nfds < 0) {
+            _exit(0);
+        }
+        if (req.op == FORKSERVER_REAP) {
+            reply.pid = waitpid(req.pid, &reply.stat, req.options);
+        } else if (req.op == FORKSERVER_SPAWN) {
+            reply.pid = serve_spawn(sock, &req, fds, nfds);
+        } else {
+            errno = EINVAL;
+        }
+        reply.err = (reply.pid < 0) ? errno : 0;
+        for (int i = 0; i < nfds; i++) {
+            close(fds[i]);
+        }
+        if (write_all(sock, &reply, sizeof(reply))) {
+            _exit(0);
+        }
+    }
+}
+#endif
+
+int systemf1_forkserver_start(void) {
+#if HAVE_PIDFD
+    int sv[2];
+    int pidfd;
+    pid_t pid;
+
+    if (_sf1_forkserver_running()) {
+        errno = EBUSY;
+        return _sf1_debug_return(__func__, NULL, -1);
+    }
+    // The children are reaped through pidfds.  Kernels before 5.3 have none.
+    pidfd = syscall(SYS_pidfd_open, getpid(), 0);
+    if (pidfd < 0) {
+        return _sf1_debug_return(__func__, NULL, -1);
+    }
+    close(pidfd);
+
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv)) {
+        return _sf1_debug_return(__func__, NULL, -1);
+    }
+    fflush(stdout);
+    fflush(stderr);
+    pid = fork();
+    if (pid < 0) {
+        close(sv[0]);
+        close(sv[1]);
+        return _sf1_debug_return(__func__, NULL, -1);
+    }
+    if (pid == 0) {
+        serve(sv[1]);
+    }
+    close(sv[1]);
+    forkserver_pid = pid;
+    __atomic_store_n(&_sf1_forkserver_fd, sv[0], __ATOMIC_RELEASE);
+    return 0;
+#else
+    errno = ENOSYS;
+    return _sf1_debug_return(__func__, NULL, -1);
+#endif
+}
+
+void systemf1_forkserver_stop(void) {
+    int sock = __atomic_exchange_n(&_sf1_forkserver_fd, -1, __ATOMIC_ACQ_REL);
+
+    if (sock < 0) {
+        return;
+    }
+    // The helper exits once it reads the end of the socket.
+    close(sock);
+    while ((waitpid(forkserver_pid, NULL, 0) < 0) && (errno == EINTR));
+    forkserver_pid = -1;
+}
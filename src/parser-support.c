@@ -74,7 +74,7 @@ void _sf1_merge_and_free_syllables (_sf1_syllable *syl, char **text_pp, char **t
         if (doing_sandbox_detection) {
             if (syl_is_trusted && !syl_is_glob) {
                 int i;
-                char *cursor = s->text;
+                const char *cursor;
                 // search for directory separators adding spans including them as we go
                 for (cursor = s->text; *cursor; cursor += i) {
                     i = strcspn(cursor, "/");
@@ -104,17 +104,17 @@ void _sf1_merge_and_free_syllables (_sf1_syllable *syl, char **text_pp, char **t
     // Allocate memory for the trusted path.
     if (is_file && !is_trusted) {
         if (sandbox_len) {
-            trusted_path = malloc(sandbox_len + 1);
+            trusted_path = _sf1_malloc(sandbox_len + 1);
             trusted_path[sandbox_len] = 0;
         } else {
-            trusted_path = strdup("");
+            trusted_path = _sf1_strdup("");
         }
         // FIXME: handle NULL path
     } else {
         sandbox_len = 0;
         trusted_path = NULL;
     }
-    text = malloc(slen + 1);
+    text = _sf1_malloc(slen + 1);
     cursor = text;
 
     /*
@@ -133,7 +133,7 @@ void _sf1_merge_and_free_syllables (_sf1_syllable *syl, char **text_pp, char **t
 
         if (is_glob && syl_escape_glob) {
             // look for glob characters and if detected, count how many need to be escaped.
-            char *start = s->text;
+            const char *start = s->text;
             while (*start) {
                 int span = strcspn(start, glob_chars);
                 memcpy(cursor, start, span);
@@ -150,7 +150,7 @@ void _sf1_merge_and_free_syllables (_sf1_syllable *syl, char **text_pp, char **t
             cursor = stpcpy(cursor, s->text);
         }
         save_next = s->next;
-        free(s);
+        _sf1_free(s);
         s = save_next;
         cursor[0] = 0;
     }
@@ -165,6 +165,35 @@ void _sf1_merge_and_free_syllables (_sf1_syllable *syl, char **text_pp, char **t
 }
 
 
+/*
+ * Frees words of syllables that were never merged, like when a parse fails.
+ */
+void _sf1_syllables_free(_sf1_syllable *syl) {
+    while (syl) {
+        _sf1_syllable *next_word = syl->next_word;
+
+        while (syl) {
+            _sf1_syllable *next = syl->next;
+            _sf1_free(syl);
+            syl = next;
+        }
+        syl = next_word;
+    }
+}
+
+/*
+ * Returns 1 if a word of syllables uses arguments that are left for
+ * _sf1_template_bind().
+ */
+static int has_slot(const _sf1_syllable *syl) {
+    for (; syl; syl = syl->next) {
+        if (syl->flags & SYL_IS_SLOT) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 _sf1_redirect *_sf1_merge_redirects (_sf1_redirect *left, _sf1_redirect *right) {
     _sf1_redirect *cursor;
     for (cursor = left; cursor->next; cursor = cursor->next);
@@ -172,15 +201,24 @@ _sf1_redirect *_sf1_merge_redirects (_sf1_redirect *left, _sf1_redirect *right)
     return left;
 }
 
+/*
+ * Returns NULL with file_syllables freed if memory runs out.
+ */
 _sf1_redirect *_sf1_create_redirect(_sf1_stream stream, _sf1_stream target, int append, _sf1_syllable *file_syllables)
 {
-    _sf1_redirect *redirect = calloc(1, sizeof(*redirect));
-    // FIXME: Handle malloc error
+    _sf1_redirect *redirect = _sf1_calloc(1, sizeof(*redirect));
+
+    if (!redirect) {
+        _sf1_syllables_free(file_syllables);
+        return NULL;
+    }
     redirect->stream = stream;
     redirect->target = target;
     redirect->append = append;
     DBG("begin: stream %d, target %d, append %d, file %p", stream, target, append, file_syllables);
-    if (file_syllables) {
+    if (has_slot(file_syllables)) {
+        redirect->file = file_syllables;
+    } else if (file_syllables) {
         int is_glob;
 
         _sf1_merge_and_free_syllables(file_syllables, &redirect->text, &redirect->trusted_path, &is_glob);
@@ -193,6 +231,41 @@ _sf1_redirect *_sf1_create_redirect(_sf1_stream stream, _sf1_stream target, int
     return redirect;
 }
 
+_sf1_redirect *_sf1_create_redirect_fd(_sf1_stream stream, int fd)
+{
+    _sf1_redirect *redirect = _sf1_create_redirect(stream, _SF1_FD, 0, NULL);
+
+    if (redirect) {
+        redirect->fd = fd;
+    }
+    return redirect;
+}
+
+/*
+ * The redirects of "&>file" and "&>>file", or of "&>%F" when file_syllables is
+ * NULL.  stderr shares stdout, which goes to the file or fd.  Returns NULL with
+ * file_syllables freed if memory runs out.
+ */
+_sf1_redirect *_sf1_create_redirect_all(int append, _sf1_syllable *file_syllables, int fd)
+{
+    _sf1_redirect *share = _sf1_create_redirect(_SF1_STDERR, _SF1_SHARE, append, NULL);
+
+    if (!share) {
+        _sf1_syllables_free(file_syllables);
+        return NULL;
+    }
+    if (file_syllables) {
+        share->next = _sf1_create_redirect(_SF1_STDOUT, _SF1_FILE, append, file_syllables);
+    } else {
+        share->next = _sf1_create_redirect_fd(_SF1_STDOUT, fd);
+    }
+    if (!share->next) {
+        _sf1_free(share);
+        return NULL;
+    }
+    return share;
+}
+
 static void append_redirect(_sf1_task *task, _sf1_redirect *redirect) {
     _sf1_redirect **next_pp = &(task->redirects);
     while (*next_pp) {
@@ -201,28 +274,283 @@ static void append_redirect(_sf1_task *task, _sf1_redirect *redirect) {
     *next_pp = redirect;
 }
 
-void _sf1_create_redirect_pipe (_sf1_task *left, _sf1_task *right) {
-    append_redirect(left, _sf1_create_redirect(_SF1_STDOUT, _SF1_PIPE, 0, NULL));
-    append_redirect(right, _sf1_create_redirect(_SF1_STDIN, _SF1_PIPE, 0, NULL));
+/*
+ * Pipes the stdout of left to the stdin of right.  Returns -1 if memory runs out.
+ */
+int _sf1_create_redirect_pipe (_sf1_task *left, _sf1_task *right) {
+    _sf1_redirect *out = _sf1_create_redirect(_SF1_STDOUT, _SF1_PIPE, 0, NULL);
+    _sf1_redirect *in = _sf1_create_redirect(_SF1_STDIN, _SF1_PIPE, 0, NULL);
+
+    if (!out || !in) {
+        _sf1_free(out);
+        _sf1_free(in);
+        return -1;
+    }
+    append_redirect(left, out);
+    append_redirect(right, in);
+    return 0;
 }
 
-_sf1_task *_sf1_create_cmd (_sf1_syllable *syllables, _sf1_redirect *redirects) {
+/*
+ * Puts a tee task between left and right for "left |> file | right".  It
+ * copies the output of left to right and to file, which is its stderr.
+ * Returns NULL with left, file_syllables, and right freed if memory runs out.
+ */
+_sf1_task *_sf1_create_tee (_sf1_task *left, _sf1_syllable *file_syllables, int append, _sf1_task *right) {
+    _sf1_task *tee = _sf1_task_create();
+    _sf1_redirect *file = _sf1_create_redirect(_SF1_STDERR, _SF1_FILE, append, file_syllables);
+    char *name = _sf1_strdup("tee");
+
+    if (!tee || !file || !name || !_sf1_task_add_arg(tee, name, NULL, 0)) {
+        _sf1_free(name);
+        _sf1_redirects_free(file);
+        _sf1_free(tee);
+        _sf1_task_free(left);
+        _sf1_task_free(right);
+        return NULL;
+    }
+    tee->is_tee = 1;
+    append_redirect(tee, file);
+
+    left->next = tee;
+    tee->next = right;
+    tee->run_if = _SF1_RUN_ALWAYS;
+    right->run_if = _SF1_RUN_ALWAYS;
+    if (_sf1_create_redirect_pipe(left, tee) || _sf1_create_redirect_pipe(tee, right)) {
+        _sf1_task_free(left);
+        return NULL;
+    }
+    return left;
+}
+
+/*
+ * Adds text, which stays the caller's, as an argument of task.  Returns NULL
+ * if memory runs out, and then trusted_path is still the caller's to free.
+ */
+static _sf1_task_arg *add_ref_arg(_sf1_task *task, const char *text, char *trusted_path, int is_glob) {
+    _sf1_task_arg *arg = _sf1_task_add_arg(task, (char *) text, trusted_path, is_glob);
+
+    if (arg) {
+        arg->owns_text = 0;
+    }
+    return arg;
+}
+
+/*
+ * Adds the arguments of a word of syllables to task and frees the syllables.
+ * A word using arguments of a template is kept as it is.  Returns -1 with the
+ * syllables freed if memory runs out.
+ */
+static int add_word(_sf1_task *task, _sf1_syllable *syllables) {
+    _sf1_task_arg *arg;
     int is_glob;
     char *text;
     char *trusted_path;
-    _sf1_syllable *next;
+
+    syllables->next_word = NULL;
+    if (has_slot(syllables)) {
+        arg = add_ref_arg(task, NULL, NULL, 0);
+        if (!arg) {
+            _sf1_syllables_free(syllables);
+            return -1;
+        }
+        arg->word = syllables;
+    } else if (syllables->flags & SYL_IS_SPLICE) {
+        // Each string is a whole untrusted word, so files are sandboxed to the current directory.
+        for (size_t i = 0; i < syllables->splice_count; i++) {
+            trusted_path = (syllables->flags & SYL_IS_FILE) ? _sf1_strdup("") : NULL;
+            if (((syllables->flags & SYL_IS_FILE) && !trusted_path) ||
+                !add_ref_arg(task, syllables->splice[i], trusted_path, 0)) {
+                _sf1_free(trusted_path);
+                _sf1_free(syllables);
+                return -1;
+            }
+        }
+        _sf1_free(syllables);
+    } else if ((syllables->flags & SYL_IS_REF) && !syllables->next) {
+        /*
+         * A whole word from a single argument needs no merging or glob escaping,
+         * so the argv points at the caller's string.  Untrusted files are
+         * sandboxed to the current directory.
+         */
+        int flags = syllables->flags;
+        int untrusted_file = (flags & SYL_IS_FILE) && !(flags & SYL_IS_TRUSTED);
+
+        trusted_path = untrusted_file ? _sf1_strdup("") : NULL;
+        if ((untrusted_file && !trusted_path) ||
+            !add_ref_arg(task, syllables->text, trusted_path, (flags & SYL_IS_GLOB) != 0)) {
+            _sf1_free(trusted_path);
+            _sf1_free(syllables);
+            return -1;
+        }
+        _sf1_free(syllables);
+    } else {
+        _sf1_merge_and_free_syllables(syllables, &text, &trusted_path, &is_glob);
+        if (!_sf1_task_add_arg(task, text, trusted_path, is_glob)) {
+            _sf1_free(text);
+            _sf1_free(trusted_path);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Builds a task from words of syllables and redirects, which it takes over.
+ * Returns NULL with everything freed if memory runs out, so no command runs
+ * with some of its arguments missing.
+ */
+_sf1_task *_sf1_create_cmd (_sf1_syllable *syllables, _sf1_redirect *redirects) {
+    _sf1_syllable *next = syllables;
     _sf1_task *task;
 
     task = _sf1_task_create();
+    if (!task) {
+        goto error;
+    }
 
     while (syllables) {
         next = syllables->next_word;
-        _sf1_merge_and_free_syllables(syllables, &text, &trusted_path, &is_glob);
-        _sf1_task_add_arg(task, text, trusted_path, is_glob);
+        if (add_word(task, syllables)) {
+            goto error;
+        }
         syllables = next;
     }
 
     _sf1_task_add_redirects(task, redirects);
 
     return task;
+
+error:
+    _sf1_syllables_free(next);
+    _sf1_redirects_free(redirects);
+    _sf1_task_free(task);
+    return NULL;
+}
+
+/*
+ * Copies a word of a template with its slots filled in from args.  The copies
+ * reference the strings of the template and of args.  Returns NULL if an
+ * argument is NULL or memory runs out.
+ */
+static _sf1_syllable *bind_syllables(const _sf1_syllable *word, const systemf1_arg *args) {
+    _sf1_syllable *head = NULL;
+    _sf1_syllable **tail = &head;
+
+    for (const _sf1_syllable *s = word; s; s = s->next) {
+        int flags = s->flags & ~SYL_IS_SLOT;
+        _sf1_syllable *b = _sf1_calloc(1, sizeof(*b) + ((flags & SYL_IS_INT) ? 20 : 0));
+
+        if (!b) {
+            goto error;
+        }
+        *tail = b;
+        tail = &b->next;
+        b->text = s->text;
+        if (!(s->flags & SYL_IS_SLOT)) {
+            b->flags = flags;
+        } else if (flags & SYL_IS_INT) {
+            snprintf(b->buf, 20, "%d", args[s->arg].d);
+            b->text = b->buf;
+        } else if (flags & SYL_IS_SPLICE) {
+            b->flags = flags;
+            b->splice = args[s->arg].sv;
+            b->splice_count = args[s->arg + 1].n;
+            for (size_t i = 0; i < b->splice_count; i++) {
+                if (!b->splice || !b->splice[i]) {
+                    fprintf(stderr, "systemf: %%@ argument %zu of %zu is NULL\n", i, b->splice_count);
+                    goto error;
+                }
+            }
+        } else {
+            b->flags = flags|SYL_IS_REF;
+            b->text = args[s->arg].s;
+            if (!b->text) {
+                fprintf(stderr, "systemf: argument %zu is NULL\n", s->arg + 1);
+                goto error;
+            }
+        }
+    }
+    return head;
+
+error:
+    _sf1_syllables_free(head);
+    return NULL;
+}
+
+/*
+ * Copies a redirect of a template with its file or fd filled in from args.
+ * Returns NULL if an argument is NULL or memory runs out.
+ */
+static _sf1_redirect *bind_redirect(const _sf1_redirect *r, const systemf1_arg *args) {
+    _sf1_redirect *redirect;
+
+    if (r->file) {
+        _sf1_syllable *file = bind_syllables(r->file, args);
+
+        return file ? _sf1_create_redirect(r->stream, r->target, r->append, file) : NULL;
+    }
+    redirect = _sf1_create_redirect(r->stream, r->target, r->append, NULL);
+    if (!redirect) {
+        return NULL;
+    }
+    if (r->target == _SF1_FD) {
+        redirect->fd = args[r->fd].d;
+    }
+    if ((r->text && !(redirect->text = _sf1_strdup(r->text))) ||
+        (r->trusted_path && !(redirect->trusted_path = _sf1_strdup(r->trusted_path)))) {
+        _sf1_redirects_free(redirect);
+        return NULL;
+    }
+    return redirect;
+}
+
+/*
+ * Builds the tasks of a template from _sf1_parse() with is_template set, with
+ * its arguments from args, so a format run many times is only parsed once.
+ * The tasks reference the strings of the template and of args, so they are
+ * freed before either.  Returns NULL on failure.
+ */
+_sf1_task *_sf1_template_bind(const _sf1_task *template, const systemf1_arg *args) {
+    _sf1_task *tasks = NULL;
+    _sf1_task **tail = &tasks;
+
+    for (const _sf1_task *t = template; t; t = t->next) {
+        _sf1_task *task = _sf1_task_create();
+
+        if (!task) {
+            goto error;
+        }
+        *tail = task;
+        tail = &task->next;
+        task->run_if = t->run_if;
+        task->is_tee = t->is_tee;
+        for (const _sf1_task_arg *a = t->args; a; a = a->next) {
+            if (a->word) {
+                _sf1_syllable *word = bind_syllables(a->word, args);
+
+                if (!word || add_word(task, word)) {
+                    goto error;
+                }
+            } else {
+                // Words without arguments are trusted, so they have no trusted_path.
+                if (!add_ref_arg(task, a->text, NULL, a->is_glob)) {
+                    goto error;
+                }
+            }
+        }
+        for (const _sf1_redirect *r = t->redirects; r; r = r->next) {
+            _sf1_redirect *redirect = bind_redirect(r, args);
+
+            if (!redirect) {
+                goto error;
+            }
+            append_redirect(task, redirect);
+        }
+    }
+    return tasks;
+
+error:
+    _sf1_task_free(tasks);
+    return NULL;
 }
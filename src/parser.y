@@ -37,50 +37,76 @@
      * don't expose the statics to the world.
      */
     #include "systemf-internal.h"
+
+    // The parser's stack grows through the allocator from systemf1_set_allocator().
+    #define YYMALLOC _sf1_malloc
+    #define YYFREE _sf1_free
 }
 
-%token <_sf1_syllable *> SYLLABLE
+%token <_sf1_syllable *> SYLLABLE SPLICE
+%token <int> FD
+%token BAD_ARG
 %token SPACE QUOTE LESSER TWO_GREATER_AND_ONE TWO_GREATER AND_GREATER GREATER TWO_GREATER_GREATER AND_GREATER_GREATER
-%token GREATER_GREATER GREATER_AND_TWO AND_AND OR_OR SEMICOLON OR
+%token GREATER_GREATER GREATER_AND_TWO AND_AND OR_OR SEMICOLON OR OR_GREATER OR_GREATER_GREATER
 %type <_sf1_syllable *> syllables words
 %type <_sf1_task *> cmd cmds
 %type <_sf1_redirect *> redirect redirects
 
+/*
+ * Frees what was built so far when the parse fails.  The start symbol has no
+ * value since Bison also destroys it when the parse succeeds.
+ */
+%destructor { _sf1_syllables_free($$); } <_sf1_syllable *>
+%destructor { _sf1_task_free($$); } <_sf1_task *>
+%destructor { _sf1_redirects_free($$); } <_sf1_redirect *>
+
 %%
 
+top:
+  cmds                 { results->tasks = $1; }
+
 cmds:
-  cmd		               { results->tasks = $1; }
-| cmd SEMICOLON cmds   { results->tasks = $1; $1->next = $3; $3->run_if = _SF1_RUN_ALWAYS; }
-| cmd OR_OR cmds       { results->tasks = $1; $1->next = $3; $3->run_if = _SF1_RUN_IF_PREV_FAILED; }
-| cmd AND_AND cmds     { results->tasks = $1; $1->next = $3; $3->run_if = _SF1_RUN_IF_PREV_SUCCEEDED;  }
-| cmd OR cmds          { results->tasks = $1; $1->next = $3; $3->run_if = _SF1_RUN_ALWAYS; 
-                         _sf1_create_redirect_pipe($1, $3); }
+  cmd		               { $$ = $1; }
+| cmd SEMICOLON cmds   { $$ = $1; $1->next = $3; $3->run_if = _SF1_RUN_ALWAYS; }
+| cmd OR_OR cmds       { $$ = $1; $1->next = $3; $3->run_if = _SF1_RUN_IF_PREV_FAILED; }
+| cmd AND_AND cmds     { $$ = $1; $1->next = $3; $3->run_if = _SF1_RUN_IF_PREV_SUCCEEDED;  }
+| cmd OR cmds          { $$ = $1; $1->next = $3; $3->run_if = _SF1_RUN_ALWAYS; 
+                         if (_sf1_create_redirect_pipe($1, $3)) { _sf1_task_free($1); YYABORT; } }
+| cmd OR_GREATER syllables OR cmds          { $$ = _sf1_create_tee($1, $3, 0, $5); if (!$$) YYABORT; }
+| cmd OR_GREATER_GREATER syllables OR cmds  { $$ = _sf1_create_tee($1, $3, 1, $5); if (!$$) YYABORT; }
 
 cmd:
-  words redirects        { $$ = _sf1_create_cmd($1, $2); }
+  words redirects        { $$ = _sf1_create_cmd($1, $2); if (!$$) YYABORT; }
 
 redirects:
   redirect redirects     { $$ = _sf1_merge_redirects($1, $2); }
 | redirect               { $$ = $1; }
 | /* empty */            { $$ = NULL; }
 
+/*
+ * The _sf1_create_redirect*() functions return NULL if memory runs out.
+ */
 redirect:
-  LESSER syllables                  { $$ = _sf1_create_redirect(_SF1_STDIN,  _SF1_FILE,  0, $2); }
-| GREATER syllables                 { $$ = _sf1_create_redirect(_SF1_STDOUT, _SF1_FILE,  0, $2); }
-| GREATER_GREATER syllables         { $$ = _sf1_create_redirect(_SF1_STDOUT, _SF1_FILE,  1, $2); }
-| GREATER_AND_TWO                   { $$ = _sf1_create_redirect(_SF1_STDOUT, _SF1_SHARE, 0, NULL); }
-| TWO_GREATER_AND_ONE               { $$ = _sf1_create_redirect(_SF1_STDERR, _SF1_SHARE, 0, NULL); }
-| TWO_GREATER syllables             { $$ = _sf1_create_redirect(_SF1_STDERR, _SF1_FILE,  0, $2); }
-| TWO_GREATER_GREATER syllables     { $$ = _sf1_create_redirect(_SF1_STDERR, _SF1_FILE,  1, $2); }
-| AND_GREATER syllables             { $$ = _sf1_create_redirect(_SF1_STDERR, _SF1_SHARE, 0, NULL);
-                                $$->next = _sf1_create_redirect(_SF1_STDOUT, _SF1_FILE,  0, $2); }
-| AND_GREATER_GREATER syllables     { $$ = _sf1_create_redirect(_SF1_STDERR, _SF1_SHARE, 1, NULL);
-                                $$->next = _sf1_create_redirect(_SF1_STDOUT, _SF1_FILE,  1, $2); }
+  LESSER syllables                  { $$ = _sf1_create_redirect(_SF1_STDIN,  _SF1_FILE,  0, $2); if (!$$) YYABORT; }
+| GREATER syllables                 { $$ = _sf1_create_redirect(_SF1_STDOUT, _SF1_FILE,  0, $2); if (!$$) YYABORT; }
+| GREATER_GREATER syllables         { $$ = _sf1_create_redirect(_SF1_STDOUT, _SF1_FILE,  1, $2); if (!$$) YYABORT; }
+| GREATER_AND_TWO                   { $$ = _sf1_create_redirect(_SF1_STDOUT, _SF1_SHARE, 0, NULL); if (!$$) YYABORT; }
+| TWO_GREATER_AND_ONE               { $$ = _sf1_create_redirect(_SF1_STDERR, _SF1_SHARE, 0, NULL); if (!$$) YYABORT; }
+| TWO_GREATER syllables             { $$ = _sf1_create_redirect(_SF1_STDERR, _SF1_FILE,  0, $2); if (!$$) YYABORT; }
+| TWO_GREATER_GREATER syllables     { $$ = _sf1_create_redirect(_SF1_STDERR, _SF1_FILE,  1, $2); if (!$$) YYABORT; }
+| AND_GREATER syllables             { $$ = _sf1_create_redirect_all(0, $2, -1); if (!$$) YYABORT; }
+| AND_GREATER_GREATER syllables     { $$ = _sf1_create_redirect_all(1, $2, -1); if (!$$) YYABORT; }
+| LESSER FD                         { $$ = _sf1_create_redirect_fd(_SF1_STDIN,  $2); if (!$$) YYABORT; }
+| GREATER FD                        { $$ = _sf1_create_redirect_fd(_SF1_STDOUT, $2); if (!$$) YYABORT; }
+| TWO_GREATER FD                    { $$ = _sf1_create_redirect_fd(_SF1_STDERR, $2); if (!$$) YYABORT; }
+| AND_GREATER FD                    { $$ = _sf1_create_redirect_all(0, NULL, $2); if (!$$) YYABORT; }
 
 words:
   syllables              { $$ = $1; }
 | syllables SPACE words  { $1->next_word = $3; $$ = $1; }
-| error                  { YYABORT; }
+| SPLICE                 { $$ = $1; }
+| SPLICE SPACE words     { $1->next_word = $3; $$ = $1; }
+| error                  { $$ = NULL; YYABORT; }
 
 syllables:
   SYLLABLE	             { $$ = $1; }
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <signal.h>
 #include <sys/wait.h>
 
 #include "systemf-internal.h"
@@ -17,7 +18,8 @@ pid_t _sf1_pid_chain_waitpids(_sf1_pid_chain_t *pid_chain, int *stat_loc, int op
     pid_t pid = 0;
     
     for (int i = 0; i < pid_chain->size; i++) {
-        pid = waitpid(pid_chain->pids[i], stat_loc, 0);
+        pid = _sf1_waitpid(pid_chain->pids[i], stat_loc, 0);
+        _SF1_PROBE(reap, pid, *stat_loc);
         // This should never fail.
         assert(pid == pid_chain->pids[i]);
     }
@@ -30,13 +32,13 @@ size_t _sf1_pid_chain_size(int capacity) {
 
 /*
  * Adds a pid to the pid_chain.  If pid_chain is NULL, it allocates.  If needs to be increased,
- * it reallocates.  On failure, errno is set and NULL is returned.
+ * it reallocates.  On failure, errno is set, NULL is returned, and pid_chain is left as it was.
  */
 _sf1_pid_chain_t *_sf1_pid_chain_add(_sf1_pid_chain_t *pid_chain, pid_t pid) {
     const int cap_steps = 4;
 
     if (!pid_chain) {
-        pid_chain = malloc(_sf1_pid_chain_size(cap_steps));
+        pid_chain = _sf1_malloc(_sf1_pid_chain_size(cap_steps));
         if (!pid_chain) {
             return NULL;
         }
@@ -45,14 +47,13 @@ _sf1_pid_chain_t *_sf1_pid_chain_add(_sf1_pid_chain_t *pid_chain, pid_t pid) {
     }
 
     if (pid_chain->capacity == pid_chain->size) {
-        _sf1_pid_chain_t *save = pid_chain;
+        _sf1_pid_chain_t *grown = _sf1_realloc(pid_chain, _sf1_pid_chain_size(pid_chain->capacity + cap_steps));
 
-        pid_chain->capacity += cap_steps;
-        pid_chain = realloc(pid_chain, _sf1_pid_chain_size(pid_chain->capacity));
-        if (!pid_chain) {
-            free(save);
+        if (!grown) {
             return NULL;
         }
+        pid_chain = grown;
+        pid_chain->capacity += cap_steps;
     }
 
     pid_chain->pids[pid_chain->size] = pid;
@@ -64,7 +65,24 @@ _sf1_pid_chain_t *_sf1_pid_chain_add(_sf1_pid_chain_t *pid_chain, pid_t pid) {
  * Removes memory for the pid_chain.  Always returns NULL.
  */
 void _sf1_pid_chain_free(_sf1_pid_chain_t *pid_chain) {
-    free(pid_chain);
+    _sf1_free(pid_chain);
+}
+
+/*
+ * Kills and reaps every pid in the pid_chain, then clears it.  For a group that
+ * failed part way through launching, which nothing will wait for.
+ */
+void _sf1_pid_chain_kill(_sf1_pid_chain_t *pid_chain) {
+    for (int i = 0; i < pid_chain->size; i++) {
+        _sf1_kill(pid_chain->pids[i], SIGKILL);
+    }
+    for (int i = 0; i < pid_chain->size; i++) {
+        int stat;
+
+        _sf1_waitpid(pid_chain->pids[i], &stat, 0);
+        _SF1_PROBE(reap, pid_chain->pids[i], stat);
+    }
+    _sf1_pid_chain_clear(pid_chain);
 }
 
 /*
@@ -0,0 +1,23 @@
+#ifndef __systemf_probes_h__
+#define __systemf_probes_h__
+
+/*
+ * USDT probes for perf, bpftrace, and SystemTap under the "systemf" provider.
+ * <sys/sdt.h> is only needed to build.  A probe is a nop and an ELF note, so it
+ * costs nothing while nothing is attached.  Without the header, probes compile
+ * to nothing and their arguments aren't evaluated.
+ */
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define _SF1_HAVE_SDT 1
+#endif
+#endif
+
+#ifdef _SF1_HAVE_SDT
+#define _SF1_PROBE(name, ...) STAP_PROBEV(systemf, name, __VA_ARGS__)
+#else
+#define _SF1_PROBE(name, ...) do { } while (0)
+#endif
+
+#endif /* __systemf_probes_h__ */
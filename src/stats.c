@@ -0,0 +1,69 @@
+#include <string.h>
+
+#include "systemf-internal.h"
+
+#define STATS_SHARDS 16
+#define STATS_WORDS (sizeof(systemf1_stats) / sizeof(unsigned long long))
+_Static_assert(sizeof(systemf1_stats) % sizeof(unsigned long long) == 0,
+               "stats are added up a word at a time");
+
+/*
+ * Threads are given shards round robin.  Threads sharing a shard still count
+ * correctly, they just share its cache lines.
+ */
+typedef struct {
+    systemf1_stats stats;
+} __attribute__((aligned(64))) stats_shard;
+
+static stats_shard stats_shards[STATS_SHARDS];
+static unsigned stats_next_shard = 0;
+static __thread systemf1_stats *stats_thread_shard = NULL;
+
+systemf1_stats *_sf1_stats_shard(void) {
+    if (!stats_thread_shard) {
+        unsigned shard = __atomic_fetch_add(&stats_next_shard, 1, __ATOMIC_RELAXED);
+        stats_thread_shard = &stats_shards[shard % STATS_SHARDS].stats;
+    }
+    return stats_thread_shard;
+}
+
+unsigned long long _sf1_call_begin(void) {
+    _SF1_STAT(calls);
+    return _sf1_trace_call();
+}
+
+static int bucket(unsigned long long ns) {
+    int b = ns ? 63 - __builtin_clzll(ns) : 0;
+    return (b < SYSTEMF1_STATS_BUCKETS) ? b : SYSTEMF1_STATS_BUCKETS - 1;
+}
+
+void _sf1_phase_end(unsigned long long call_id, int phase, unsigned long long start_ns,
+                    pid_t pid, int status) {
+    unsigned long long duration = _sf1_now_ns() - start_ns;
+
+    _SF1_STAT(latency[phase][bucket(duration)]);
+    if (call_id) {
+        _sf1_trace_record(call_id, phase, start_ns, duration, pid, status);
+    }
+}
+
+void systemf1_stats_get(systemf1_stats *stats) {
+    unsigned long long *total = (unsigned long long *) stats;
+
+    memset(stats, 0, sizeof(*stats));
+    for (int s = 0; s < STATS_SHARDS; s++) {
+        unsigned long long *words = (unsigned long long *) &stats_shards[s].stats;
+        for (size_t i = 0; i < STATS_WORDS; i++) {
+            total[i] += __atomic_load_n(&words[i], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void systemf1_stats_reset(void) {
+    for (int s = 0; s < STATS_SHARDS; s++) {
+        unsigned long long *words = (unsigned long long *) &stats_shards[s].stats;
+        for (size_t i = 0; i < STATS_WORDS; i++) {
+            __atomic_store_n(&words[i], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
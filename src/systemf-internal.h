@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <glob.h>
+#include "systemf.h"
+#include "probes.h"
 
 typedef enum {
     _SF1_STDIN,
@@ -12,6 +14,7 @@ typedef enum {
     _SF1_STDERR,
     _SF1_PIPE,
     _SF1_FILE,
+    _SF1_FD,    // A file descriptor owned by the caller.
 } _sf1_stream;
 
 typedef enum {
@@ -23,9 +26,11 @@ typedef enum {
 typedef struct _sf1_task_arg_ {
     struct _sf1_task_arg_ *next;
     int is_glob;
+    int owns_text;  // text is freed with the task.
     char *text;
     char *trusted_path;
     glob_t glob;
+    struct _sf1_syllable_ *word; // In a template, the syllables of a word using arguments.
 } _sf1_task_arg;
 
 typedef struct _sf1_redirect_ {
@@ -35,6 +40,8 @@ typedef struct _sf1_redirect_ {
     char *text;
     char *trusted_path;
     int append;
+    int fd; // For _SF1_FD.  In a template, the index of the argument with the fd.
+    struct _sf1_syllable_ *file; // In a template, the syllables of a file using arguments.
 } _sf1_redirect;
 
 typedef struct _sf1_task_ {
@@ -42,6 +49,7 @@ typedef struct _sf1_task_ {
     _sf1_run_if run_if;
     _sf1_redirect *redirects;
     _sf1_task_arg *args;
+    int is_tee;     // Run by _sf1_tee() in a thread rather than argv.
     struct _sf1_task_ *next;
 } _sf1_task;
 
@@ -50,11 +58,16 @@ typedef struct _sf1_task_files_ {
     int out;
     int err;
     int out_rd_pipe;
+    int caller_owned; // Bit n is set when child fd n is one of the caller's and must not be closed.
 } _sf1_task_files;
 
 typedef struct {
     _sf1_task *tasks;
     va_list *argpp;
+    const systemf1_arg *args; // When not NULL, arguments come from here instead of argpp.
+    size_t nargs;
+    size_t argi;
+    int is_template; // Arguments are left as slots for _sf1_template_bind().
 } _sf1_parse_args ;
 
 typedef enum {
@@ -62,13 +75,21 @@ typedef enum {
     SYL_IS_GLOB=2,
     SYL_IS_FILE=4,
     SYL_IS_TRUSTED=8,
+    SYL_IS_SPLICE=16, // A whole word of splice_count arguments referenced in place.
+    SYL_IS_REF=32,    // text is the caller's argument rather than buf.
+    SYL_IS_SLOT=64,   // In a template, argument arg, or args arg and arg + 1 for a splice.
+    SYL_IS_INT=128,   // A slot for %d.
 } _sf1_syl_flags;
 
 typedef struct _sf1_syllable_ {
     struct _sf1_syllable_ *next;
     struct _sf1_syllable_ *next_word;
     _sf1_syl_flags flags;
-    char text[];
+    const char *const *splice;
+    size_t splice_count;
+    size_t arg;
+    const char *text;
+    char buf[];
 } _sf1_syllable;
 
 typedef struct {
@@ -77,15 +98,70 @@ typedef struct {
     pid_t pids[];
 } _sf1_pid_chain_t;
 
+/*
+ * A run is a single chain of tasks working its way through execution.
+ * Tasks are launched up to and including the next task that isn't piped.
+ * Once that group of processes has been reaped the next group is decided.
+ */
+typedef struct {
+    _sf1_task *tasks;     // The whole chain.  Tasks are ready to run again after cleanup.
+    _sf1_task *next_task; // The next task to launch or NULL when there are none.
+    _sf1_task *wait_task; // The last task launched.  Its status decides what runs next.
+    _sf1_pid_chain_t *pid_chain;
+    _sf1_task_files files;
+    char *const *envp;    // The children's environment.
+    int dirfd;            // The children's working directory or AT_FDCWD.
+    int cgroup_fd;        // The children's cgroup or -1.
+    const systemf1_opts *limits; // Applied to the children before they exec.  May be NULL.
+    int pipe_size;        // Capacity of the pipes between the children or 0.
+    unsigned long long call_id;     // For tracing.  0 when the run isn't traced.
+    unsigned long long launched_ns; // When the current group was launched, for tracing.
+    int admitted;         // Children of the current group counted against the admission limit.
+    int defer_admission;  // Return _SF1_RUN_DEFERRED instead of waiting to be admitted.
+    struct _sf1_env_ *env; // From _sf1_run_start().
+    int dirfd_owned;      // dirfd is closed by _sf1_run_finish().
+    int retval;
+} _sf1_run;
+
+/*
+ * What a child is started with: argv run with envp in dirfd, with in, out, and
+ * err as its stdin, stdout, and stderr.
+ */
+typedef struct {
+    char *const *argv;
+    char *const *envp;
+    int in;
+    int out;
+    int err;
+    int dirfd;            // AT_FDCWD to stay in the working directory.
+    int cgroup_fd;        // -1 when there is no cgroup.
+    const systemf1_opts *limits; // May be NULL.
+} _sf1_spawn;
+
+// _sf1_run_launch() returns this when the group was not admitted and defer_admission is set.
+#define _SF1_RUN_DEFERRED 2
+
 #ifndef YY_TYPEDEF_YY_SCANNER_T
     #define YY_TYPEDEF_YY_SCANNER_T
     typedef void* yyscan_t;
 #endif
 
+extern _sf1_task *_sf1_parse(const char *fmt, _sf1_parse_args *args);
+extern char *_sf1_parse_next_str(_sf1_parse_args *args);
+extern int _sf1_parse_next_int(_sf1_parse_args *args);
+extern const char *const *_sf1_parse_next_strv(_sf1_parse_args *args);
+extern size_t _sf1_parse_next_size(_sf1_parse_args *args);
+
 extern _sf1_redirect *_sf1_merge_redirects(_sf1_redirect *left, _sf1_redirect *right);
 extern _sf1_redirect *_sf1_create_redirect(_sf1_stream stream, _sf1_stream target, int append, _sf1_syllable *file_syllables);
+extern _sf1_redirect *_sf1_create_redirect_fd(_sf1_stream stream, int fd);
+extern _sf1_redirect *_sf1_create_redirect_all(int append, _sf1_syllable *file_syllables, int fd);
+extern void _sf1_merge_and_free_syllables(_sf1_syllable *syl, char **text_pp, char **trusted_path_pp, int *is_glob_p);
+extern void _sf1_syllables_free(_sf1_syllable *syl);
 extern _sf1_task *_sf1_create_cmd(_sf1_syllable *syllables, _sf1_redirect *redirects);
-extern void _sf1_create_redirect_pipe (_sf1_task *left, _sf1_task *right);
+extern int _sf1_create_redirect_pipe (_sf1_task *left, _sf1_task *right);
+extern _sf1_task *_sf1_create_tee(_sf1_task *left, _sf1_syllable *file_syllables, int append, _sf1_task *right);
+extern _sf1_task *_sf1_template_bind(const _sf1_task *template, const systemf1_arg *args);
 
 extern int _sf1_file_sandbox_check(char *trusted_path, char *path);
 
@@ -93,12 +169,105 @@ extern pid_t _sf1_pid_chain_waitpids(_sf1_pid_chain_t *pid_chain, int *stat_loc,
 extern _sf1_pid_chain_t *_sf1_pid_chain_add(_sf1_pid_chain_t *pid_chain, pid_t pid);
 extern void _sf1_pid_chain_free(_sf1_pid_chain_t *pid_chain);
 extern void _sf1_pid_chain_clear(_sf1_pid_chain_t *pid_chain);
+extern void _sf1_pid_chain_kill(_sf1_pid_chain_t *pid_chain);
+
+extern int _sf1_admission_acquire(int count, int try);
+extern void _sf1_admission_release(int count);
+
+typedef struct _sf1_env_ _sf1_env;
+extern char *const *_sf1_env_acquire(const systemf1_opts *opts, _sf1_env **env);
+extern void _sf1_env_release(_sf1_env *env);
+extern void _sf1_env_cache_flush(void);
+extern int _sf1_cwd_open(const systemf1_opts *opts, int *owned);
+extern int _sf1_glob_at(int dirfd, const char *pattern, glob_t *pglob);
+extern int _sf1_child_prepare(const systemf1_opts *opts, int *cgroup_fd);
+extern pid_t _sf1_child_fork(int cgroup_fd, int *in_cgroup);
+extern int _sf1_child_join_cgroup(int cgroup_fd);
+extern int _sf1_child_limit(const systemf1_opts *opts);
+extern pid_t _sf1_child_spawn(const _sf1_spawn *spawn);
+
+extern int _sf1_forkserver_fd;
+static inline int _sf1_forkserver_running(void) {
+    return __builtin_expect(__atomic_load_n(&_sf1_forkserver_fd, __ATOMIC_RELAXED) >= 0, 0);
+}
+extern pid_t _sf1_forkserver_spawn(const _sf1_spawn *spawn);
+extern pid_t _sf1_waitpid(pid_t pid, int *stat, int options);
+
+/*
+ * Builtins run in a thread and are tracked in a pid_chain by an id at or above
+ * _SF1_BUILTIN_PID, which no pid reaches.  Send any pid of a pid_chain signals with
+ * _sf1_kill() and reap it with _sf1_waitpid().
+ */
+#define _SF1_BUILTIN_PID 0x40000000
+static inline int _sf1_builtin_is(pid_t pid) {
+    return pid >= _SF1_BUILTIN_PID;
+}
+typedef struct {
+    systemf1_builtin_fn fn;
+    void *ctx;
+} _sf1_builtin;
+extern int _sf1_builtin_find(const char *name, _sf1_builtin *found);
+extern pid_t _sf1_builtin_spawn(const _sf1_builtin *builtin, const _sf1_spawn *spawn);
+extern pid_t _sf1_builtin_wait(pid_t id, int *stat, int options);
+extern int _sf1_builtin_fd(pid_t id);
+extern int _sf1_kill(pid_t pid, int sig);
+extern int _sf1_tee(const systemf1_builtin_call *call);
+
+extern void *_sf1_malloc(size_t size);
+extern void *_sf1_calloc(size_t count, size_t size);
+extern void *_sf1_realloc(void *ptr, size_t size);
+extern void _sf1_free(void *ptr);
+extern char *_sf1_strdup(const char *s);
+
+extern int _sf1_debug_flags;
+static inline int _sf1_debugging(int flag) {
+    return __builtin_expect(__atomic_load_n(&_sf1_debug_flags, __ATOMIC_RELAXED) & flag, 0);
+}
+extern unsigned long long _sf1_now_ns(void);
+extern void _sf1_debug_exec(const _sf1_task *task, pid_t pid);
+extern void _sf1_debug_exit(pid_t pid, int stat, unsigned long long launched_ns);
+extern int _sf1_debug_return(const char *func, const char *what, int ret);
+
+typedef struct _sf1_trace_ring_ _sf1_trace_ring;
+extern _sf1_trace_ring *_sf1_trace_active;
+static inline int _sf1_tracing(void) {
+    return __builtin_expect(__atomic_load_n(&_sf1_trace_active, __ATOMIC_RELAXED) != NULL, 0);
+}
+extern unsigned long long _sf1_trace_call(void);
+extern void _sf1_trace_record(unsigned long long call_id, int phase, unsigned long long start_ns,
+                              unsigned long long duration_ns, pid_t pid, int status);
+
+/*
+ * Process-wide counters are kept in a shard per thread and counted with _SF1_STAT().
+ */
+extern systemf1_stats *_sf1_stats_shard(void);
+#define _SF1_STAT(field) __atomic_add_fetch(&_sf1_stats_shard()->field, 1, __ATOMIC_RELAXED)
+
+/*
+ * Every call starts with _sf1_call_begin(), which returns its trace call_id or 0
+ * when it isn't traced.  A phase of a call is timed with:
+ *   unsigned long long start = _sf1_now_ns();
+ *   ...
+ *   _sf1_phase_end(call_id, SYSTEMF1_TRACE_*, start, pid, status);
+ * which adds it to the latency histograms and to the trace.
+ */
+extern unsigned long long _sf1_call_begin(void);
+extern void _sf1_phase_end(unsigned long long call_id, int phase, unsigned long long start_ns,
+                           pid_t pid, int status);
 
 extern _sf1_task *_sf1_task_create();
-extern int _sf1_tasks_run(_sf1_task *task);
+extern int _sf1_tasks_run(_sf1_task *task, const systemf1_opts *opts, unsigned long long call_id);
+extern int _sf1_run_init(_sf1_run *run, _sf1_task *tasks);
+extern int _sf1_run_start(_sf1_run *run, _sf1_task *tasks, const systemf1_opts *opts, unsigned long long call_id);
+extern int _sf1_run_finish(_sf1_run *run);
+extern int _sf1_run_launch(_sf1_run *run);
+extern int _sf1_run_reaped(_sf1_run *run, int stat);
+extern void _sf1_run_cleanup(_sf1_run *run);
 extern _sf1_task_arg *_sf1_task_add_arg(_sf1_task *task, char *text, char *trusted_path, int is_glob);
 extern void _sf1_task_add_redirects(_sf1_task *task, _sf1_redirect *redirect);
+extern int _sf1_task_own_args(_sf1_task *task);
 extern void _sf1_task_free(_sf1_task *task);
+extern void _sf1_redirects_free(_sf1_redirect *redirect);
 extern char *_sf1_stream_name(_sf1_stream);
 extern void _sf1_close_upper_fd(void);
 
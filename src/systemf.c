@@ -1,6 +1,8 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 
 #include "derived-parser.h"
 #include "derived-lexer.h"
@@ -11,32 +13,207 @@ int _sf1_yyerror(_SF1_YYLTYPE *locp, yyscan_t scanner, _sf1_parse_args *result,
   return 1;
 }
 
-int systemf1(const char *fmt, ...)
+/*
+ * Returns the next string argument from either the array of arguments or the varargs.
+ * Running off the end of the array returns "" and is reported by _sf1_parse().
+ */
+char *_sf1_parse_next_str(_sf1_parse_args *args) {
+    if (!args->args) {
+        return va_arg(*args->argpp, char *);
+    }
+    if (args->argi++ >= args->nargs) {
+        return "";
+    }
+    return (char *) args->args[args->argi - 1].s;
+}
+
+/*
+ * Returns the next int argument.  See _sf1_parse_next_str().
+ */
+int _sf1_parse_next_int(_sf1_parse_args *args) {
+    if (!args->args) {
+        return va_arg(*args->argpp, int);
+    }
+    if (args->argi++ >= args->nargs) {
+        return 0;
+    }
+    return args->args[args->argi - 1].d;
+}
+
+/*
+ * Returns the next string array argument.  See _sf1_parse_next_str().
+ */
+const char *const *_sf1_parse_next_strv(_sf1_parse_args *args) {
+    if (!args->args) {
+        return va_arg(*args->argpp, const char *const *);
+    }
+    if (args->argi++ >= args->nargs) {
+        return NULL;
+    }
+    return args->args[args->argi - 1].sv;
+}
+
+/*
+ * Returns the next size_t argument.  See _sf1_parse_next_str().
+ */
+size_t _sf1_parse_next_size(_sf1_parse_args *args) {
+    if (!args->args) {
+        return va_arg(*args->argpp, size_t);
+    }
+    if (args->argi++ >= args->nargs) {
+        return 0;
+    }
+    return args->args[args->argi - 1].n;
+}
+
+/*
+ * Parses fmt into a chain of tasks with arguments coming from args.
+ * Returns NULL on failure.
+ */
+_sf1_task *_sf1_parse(const char *fmt, _sf1_parse_args *args)
 {
     // extern int _sf1_yydebug; _sf1_yydebug = 1; // for debugging issues
-    va_list argp;
     yyscan_t scanner;
-    _sf1_parse_args *result = calloc(1, sizeof(_sf1_parse_args));
-
-    va_start(argp, fmt);
-    result->argpp = &argp;
+    YY_BUFFER_STATE buf;
+    int ret;
 
     if (_sf1_yylex_init(&scanner)) {
         fprintf(stderr, "systemf: Unexpected failure in yylex_init().");
-        return -1;
-    } 
-    YY_BUFFER_STATE buf = _sf1_yy_scan_string(fmt, scanner);
-    if (_sf1_yyparse(scanner, result)) {
-        free(result);
-        return -1;
+        return NULL;
     }
-    va_end(argp);
+    buf = _sf1_yy_scan_string(fmt, scanner);
+    ret = _sf1_yyparse(scanner, args);
     _sf1_yy_delete_buffer(buf, scanner);
     _sf1_yylex_destroy(scanner);
+    if (ret) {
+        return NULL;
+    }
+
+    if ((args->args || args->is_template) && (args->argi != args->nargs)) {
+        fprintf(stderr, "systemf: %zu arguments supplied, but the format uses %zu\n", args->nargs, args->argi);
+        _sf1_task_free(args->tasks);
+        return NULL;
+    }
+    return args->tasks;
+}
+
+int systemf1v(const char *fmt, va_list ap)
+{
+    return systemf1_exv(NULL, fmt, ap);
+}
+
+int systemf1_ex(const systemf1_opts *opts, const char *fmt, ...)
+{
+    va_list argp;
+    int ret;
+
+    va_start(argp, fmt);
+    ret = systemf1_exv(opts, fmt, argp);
+    va_end(argp);
+
+    return ret;
+}
+
+/*
+ * Parses fmt with args and runs it.  func is the entry point for debugging.
+ */
+static int parse_and_run(const systemf1_opts *opts, const char *fmt, _sf1_parse_args *args, const char *func)
+{
+    _sf1_task *tasks;
+    unsigned long long call_id = _sf1_call_begin();
+    unsigned long long start = _sf1_now_ns();
+
+    _SF1_PROBE(parse__start, fmt);
+    tasks = _sf1_parse(fmt, args);
+    _SF1_PROBE(parse__end, fmt, tasks != NULL);
+    _sf1_phase_end(call_id, SYSTEMF1_TRACE_PARSE, start, 0, tasks ? 0 : -1);
+    if (!tasks) {
+        _SF1_STAT(parse_errors);
+        return _sf1_debug_return(func, fmt, -1);
+    }
+
+    int ret = _sf1_tasks_run(tasks, opts, call_id);
+    _sf1_task_free(tasks);
+
+    return _sf1_debug_return(func, fmt, ret);
+}
+
+int systemf1_exv(const systemf1_opts *opts, const char *fmt, va_list ap)
+{
+    va_list argp;
+    _sf1_parse_args args = { .argpp = &argp };
+    int ret;
+
+    // The lexer needs a va_list it can point to, and a va_list parameter may not be one.
+    va_copy(argp, ap);
+    ret = parse_and_run(opts, fmt, &args, __func__);
+    va_end(argp);
+
+    return ret;
+}
+
+int systemf1_args(const systemf1_opts *opts, const char *fmt, const systemf1_arg *args, size_t nargs)
+{
+    static const systemf1_arg none;
+    // A NULL args would have the lexer read varargs.
+    _sf1_parse_args parse_args = { .args = args ? args : &none, .nargs = nargs };
+
+    return parse_and_run(opts, fmt, &parse_args, __func__);
+}
+
+int systemf1(const char *fmt, ...)
+{
+    va_list argp;
+    int ret;
+
+    va_start(argp, fmt);
+    ret = systemf1v(fmt, argp);
+    va_end(argp);
+
+    return ret;
+}
+
+int systemf1_argv(const char *const argv[], const systemf1_opts *opts)
+{
+    const int *arg_flags = opts ? opts->arg_flags : NULL;
+    _sf1_task *task;
+    int ret;
+
+    if (!argv || !argv[0]) {
+        errno = EINVAL;
+        return _sf1_debug_return(__func__, NULL, -1);
+    }
+
+    task = _sf1_task_create();
+    if (!task) {
+        return _sf1_debug_return(__func__, argv[0], -1);
+    }
+
+    // The caller's strings outlive the run, so they are used in place.
+    for (int i = 0; argv[i]; i++) {
+        int flags = arg_flags ? arg_flags[i] : 0;
+        char *trusted_path = NULL;
+        _sf1_task_arg *arg;
+
+        if (flags & SYSTEMF1_ARG_SANDBOX) {
+            // The whole argument is untrusted so it is sandboxed to the current directory.
+            trusted_path = _sf1_strdup("");
+            if (!trusted_path) {
+                _sf1_task_free(task);
+                return _sf1_debug_return(__func__, argv[0], -1);
+            }
+        }
+        arg = _sf1_task_add_arg(task, (char *) argv[i], trusted_path, flags & SYSTEMF1_ARG_GLOB);
+        if (!arg) {
+            _sf1_free(trusted_path);
+            _sf1_task_free(task);
+            return _sf1_debug_return(__func__, argv[0], -1);
+        }
+        arg->owns_text = 0;
+    }
 
-    int ret = _sf1_tasks_run(result->tasks);
-    _sf1_task_free(result->tasks);
-    free(result);
+    ret = _sf1_tasks_run(task, opts, _sf1_call_begin());
+    _sf1_task_free(task);
 
-    return (ret);
+    return _sf1_debug_return(__func__, argv[0], ret);
 }
@@ -1,12 +1,351 @@
 #ifndef __systemf_h__
 #define __systemf_h__
 #include <stdio.h>
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 extern int systemf1(const char *fmt, ...);
 
+/*
+ * The same as systemf1() with the arguments in a va_list, for wrappers of systemf1().
+ * Entry points taking a fmt and varargs each have a v variant like this.  ap is
+ * not consumed, so the caller may still va_end() or reuse it.
+ */
+extern int systemf1v(const char *fmt, va_list ap);
+
+/*
+ * Per argument flags for systemf1_argv().
+ */
+enum {
+ SYSTEMF1_ARG_SANDBOX = 0x01,  // Like %p.  The argument must stay within the current directory.
+ SYSTEMF1_ARG_GLOB = 0x02,     // The argument is a file glob.  Add SYSTEMF1_ARG_SANDBOX for %*p.
+};
+
+/*
+ * Options for systemf1_ex(), systemf1_argv(), and systemf1_cmd_run_ex().  Zero or
+ * NULL for anything not in use.
+ *
+ * The children get environ unless envp is set.  env_set and env_unset are applied
+ * on top of that.  Merged environments are cached, so calls repeating the same
+ * overrides on an unchanged base don't build them again.
+ *
+ * cwd and cwd_fd set the children's working directory without changing the caller's.
+ * Relative redirects and globs are resolved from there too.  cwd_fd is an open
+ * directory (O_PATH is enough) and stays the caller's.  With both, cwd is relative
+ * to cwd_fd.  A cwd_fd of 0 is not set.
+ *
+ * cgroup is a cgroup v2 directory the children start in.  They are created there
+ * with clone3(CLONE_INTO_CGROUP) where the kernel has it and move themselves there
+ * before exec otherwise.  The rest are applied by each child just before it execs:
+ * rlimits with setrlimit(), nice with nice(), ioprio (as IOPRIO_PRIO_VALUE()) with
+ * ioprio_set(), and cpu_affinity (a cpu_set_t of cpu_affinity_size bytes) with
+ * sched_setaffinity().  A child that can't apply them is killed before it execs.
+ *
+ * pipe_size sets the capacity of the pipes between the children with F_SETPIPE_SZ,
+ * so fewer context switches are needed to move a lot of data.  It is capped at
+ * /proc/sys/fs/pipe-max-size, rounded up by the kernel, and ignored where pipes
+ * can't be resized.  0 leaves the default, usually 64 KiB.
+ */
+typedef struct {
+    int resource;                  // RLIMIT_*.
+    unsigned long long cur;        // RLIM_INFINITY for no limit.
+    unsigned long long max;
+} systemf1_rlimit;
+
+typedef struct {
+    const int *arg_flags;          // systemf1_argv() only.  SYSTEMF1_ARG_* for each argv entry.
+    char *const *envp;             // NULL terminated environment to use instead of environ.
+    const char *const *env_set;    // NULL terminated "NAME=value" entries to add or replace.
+    const char *const *env_unset;  // NULL terminated names to remove.
+    const char *cwd;               // Working directory of the children.
+    int cwd_fd;                    // Working directory of the children as a directory fd.
+    const char *cgroup;            // cgroup v2 directory the children start in.
+    const systemf1_rlimit *rlimits; // rlimit_count resource limits of the children.
+    size_t rlimit_count;
+    int nice;                      // Added to the children's nice value.
+    int ioprio;                    // I/O class and priority of the children.
+    const void *cpu_affinity;      // CPUs the children may run on.
+    size_t cpu_affinity_size;
+    size_t pipe_size;              // Capacity of the pipes between the children.  0 for the default.
+} systemf1_opts;
+
+/*
+ * systemf1() and systemf1v() with options.  opts may be NULL.
+ */
+extern int systemf1_ex(const systemf1_opts *opts, const char *fmt, ...);
+extern int systemf1_exv(const systemf1_opts *opts, const char *fmt, va_list ap);
+
+/*
+ * Runs argv[0] with the NULL terminated argv without parsing anything.  Arguments are
+ * passed as is, like a %s that is a whole word, unless opts->arg_flags says otherwise.
+ * opts may be NULL.  Returns what systemf1() would.
+ */
+extern int systemf1_argv(const char *const argv[], const systemf1_opts *opts);
+
+/*
+ * Builds the same commands a fmt describes without a fmt.  The strings are copied.
+ * A command can be run any number of times, but not from two threads at once.
+ *
+ * systemf1_cmd_new() starts a command running path and returns NULL on failure.
+ * systemf1_cmd_arg() adds an argument.  flags are SYSTEMF1_ARG_* as with systemf1_argv().
+ * systemf1_cmd_glob() adds a glob, the same as systemf1_cmd_arg() with SYSTEMF1_ARG_GLOB.
+ * systemf1_cmd_redirect() redirects stream (0, 1, or 2) of the last command to path.
+ *   A NULL path shares stdout and stderr like ">&2" and "2>&1".  With
+ *   SYSTEMF1_REDIRECT_APPEND, the file is appended to.
+ * systemf1_cmd_redirect_fd() redirects stream of the last command to the caller's fd
+ *   like %F.  fd is not closed and must stay open while the command is in use.
+ * systemf1_cmd_pipe_to(), systemf1_cmd_and_then(), systemf1_cmd_or_else(), and
+ *   systemf1_cmd_then() append right to left like "|", "&&", "||", and ";".  right
+ *   becomes part of left and must not be used afterwards.
+ * systemf1_cmd_run() runs the commands and returns what systemf1() would.
+ * systemf1_cmd_run_ex() runs the commands with opts.  opts->arg_flags isn't used.
+ * systemf1_cmd_free() frees the commands.
+ *
+ * The functions returning int return 0 on success and -1 with errno set on failure.
+ */
+typedef struct systemf1_cmd_ systemf1_cmd;
+enum {
+ SYSTEMF1_REDIRECT_APPEND = 0x01,
+};
+extern systemf1_cmd *systemf1_cmd_new(const char *path);
+extern int systemf1_cmd_arg(systemf1_cmd *cmd, const char *arg, int flags);
+extern int systemf1_cmd_glob(systemf1_cmd *cmd, const char *pattern, int flags);
+extern int systemf1_cmd_redirect(systemf1_cmd *cmd, int stream, const char *path, int flags);
+extern int systemf1_cmd_redirect_fd(systemf1_cmd *cmd, int stream, int fd);
+extern int systemf1_cmd_pipe_to(systemf1_cmd *left, systemf1_cmd *right);
+extern int systemf1_cmd_and_then(systemf1_cmd *left, systemf1_cmd *right);
+extern int systemf1_cmd_or_else(systemf1_cmd *left, systemf1_cmd *right);
+extern int systemf1_cmd_then(systemf1_cmd *left, systemf1_cmd *right);
+extern int systemf1_cmd_run(systemf1_cmd *cmd);
+extern int systemf1_cmd_run_ex(systemf1_cmd *cmd, const systemf1_opts *opts);
+extern void systemf1_cmd_free(systemf1_cmd *cmd);
+
+/*
+ * An argument supplied through an array instead of through the varargs.
+ * Use s for %s, %p, %!p, and %*p and d for %d and %F.  %@s and %@p take two,
+ * sv followed by n.
+ */
+typedef union {
+    const char *s;
+    int d;
+    const char *const *sv;
+    size_t n;
+} systemf1_arg;
+
+/*
+ * Runs fmt with opts (which may be NULL) once for each of count argument tuples
+ * with no more than max_parallel of them running at a time (max_parallel <= 0
+ * uses the number of online cpus).  Tuple i is args[i * nargs] through
+ * args[i * nargs + nargs - 1].  fmt is only parsed once.
+ *
+ * results[i] is set to what systemf1_ex() would have returned for tuple i.
+ * Returns 0 once all items have run or -1 with errno set if the batch could not be run.
+ */
+extern int systemf1_batch(const systemf1_opts *opts, const char *fmt, const systemf1_arg *args, size_t nargs,
+                          size_t count, int max_parallel, int *results);
+
+/*
+ * systemf1_ex() with the nargs arguments in args instead of the varargs, for
+ * callers like systemf.hpp that know the types.  opts may be NULL.  Supplying a
+ * different number of arguments than fmt uses fails like a syntax error.
+ */
+extern int systemf1_args(const systemf1_opts *opts, const char *fmt, const systemf1_arg *args, size_t nargs);
+
+/*
+ * Runs fmt like systemf1_ex() without waiting for it, for event loops.
+ *
+ * systemf1_start(), systemf1_startv(), and systemf1_start_args() launch the first
+ *   group of commands and return NULL with nothing running if fmt can't be parsed
+ *   or there is no memory.  The arguments are copied, so they may be freed once these
+ *   return, but opts and everything it points to must stay valid until the run finishes.
+ * systemf1_proc_fd() returns an fd that is readable when a child of the running
+ *   group exits, or -1 on systems without pidfds.  It stays the same for the whole run.
+ * systemf1_proc_poll() reaps what has exited and launches what runs next without
+ *   blocking.  It returns 1 while the run is going.  Once it has finished it returns 0
+ *   and sets *result to what systemf1() would have returned.  Call it after starting
+ *   and each time the fd is readable.
+ * systemf1_proc_wait() blocks until the run finishes and returns the result.
+ * systemf1_proc_kill() sends sig to the running group and runs nothing after it.
+ * systemf1_proc_free() kills the run with SIGKILL and reaps it if it is still
+ *   going, then frees it.
+ */
+typedef struct systemf1_proc_ systemf1_proc;
+extern systemf1_proc *systemf1_start(const systemf1_opts *opts, const char *fmt, ...);
+extern systemf1_proc *systemf1_startv(const systemf1_opts *opts, const char *fmt, va_list ap);
+extern systemf1_proc *systemf1_start_args(const systemf1_opts *opts, const char *fmt, const systemf1_arg *args,
+                                          size_t nargs);
+extern int systemf1_proc_fd(const systemf1_proc *proc);
+extern int systemf1_proc_poll(systemf1_proc *proc, int *result);
+extern int systemf1_proc_wait(systemf1_proc *proc);
+extern int systemf1_proc_kill(systemf1_proc *proc, int sig);
+extern void systemf1_proc_free(systemf1_proc *proc);
+
+/*
+ * Process wide limit on the number of children systemf has running at once.  A
+ * pipeline is admitted all at once, so "a | b | c" needs room for 3 children.
+ * A pipeline bigger than the limit only runs when nothing else is running.
+ * Tees and builtins run as threads of the caller and aren't counted.
+ *
+ * systemf1_admission_set() sets the limit (<= 0 is unlimited, the default) and
+ * returns the previous one.  Without SYSTEMF1_ADMIT_TRY, callers wait their turn in
+ * order.  With it, a call that would wait returns -1 with errno set to EAGAIN instead.
+ */
+enum {
+ SYSTEMF1_ADMIT_TRY = 0x01,
+};
+extern int systemf1_admission_set(int max_children, int flags);
+
+typedef struct {
+    unsigned long admitted;          // Pipelines admitted.
+    unsigned long rejected;          // Pipelines refused in try mode.
+    unsigned long waited;            // Pipelines that had to wait to be admitted.
+    unsigned long long wait_ns;      // Total time spent waiting.
+    unsigned long long max_wait_ns;  // Longest single wait.
+    int running;                     // Children admitted and not yet reaped.
+    int queued;                      // Callers waiting right now.
+} systemf1_admission_stats;
+extern void systemf1_admission_stats_get(systemf1_admission_stats *stats);
+
+/*
+ * Moves fork() and exec() out of the caller into a small helper process, so the
+ * cost of forking doesn't grow with the caller's memory and threads.  Parsing,
+ * globbing, and the sandbox still happen in the caller.  The helper is sent the
+ * argv, environment, and fds of each child and forks it.
+ *
+ * systemf1_forkserver_start() forks the helper.  Call it early, while the caller
+ * is still small and has a single thread.  It returns -1 with errno set if the
+ * helper can't be started, ENOSYS on systems without pidfds, and EBUSY if it is
+ * already running.  systemf1_forkserver_stop() stops it and returns to forking
+ * from the caller.  Only start or stop it while nothing is running.
+ *
+ * While it runs, the children are the helper's rather than the caller's, and the
+ * helper is the caller's only child.
+ */
+extern int systemf1_forkserver_start(void);
+extern void systemf1_forkserver_stop(void);
+
+/*
+ * A builtin is a command run by a C function in a thread of the caller instead
+ * of in a child, for commands so small that fork() and exec() cost more than the
+ * work.  A task whose argv[0] is exactly the name of a builtin calls its fn with
+ * the task's argv, environment, working directory (AT_FDCWD for the caller's),
+ * and stdin, stdout, and stderr as fds.  The fds are closed when fn returns, so
+ * pipes and redirects work as they do for a child.  fn's return & 0xff is the
+ * exit status.
+ *
+ * systemf1_register_builtin() adds or replaces the builtin called name, or removes
+ * it when fn is NULL.  Returns -1 with errno set on failure.
+ *
+ * A builtin gets none of the limits or the cgroup of opts.  It can't be
+ * interrupted either: a signal sent to one, as systemf1_proc_kill() and freeing
+ * a running systemf1_proc do, becomes its status once fn returns.  cancel is
+ * readable once it has been sent one (it is -1 without eventfds).  Freeing the
+ * systemf1_proc waits for fn to return, so a builtin that can block should poll
+ * cancel along with its fds and return when it is readable.  Writing to a pipe
+ * nobody reads fails with EPIPE instead of raising SIGPIPE.
+ */
+typedef struct {
+    int argc;
+    char *const *argv;
+    char *const *envp;
+    int in;
+    int out;
+    int err;
+    int dirfd;
+    int cancel;                    // Readable once it is signaled.
+    void *ctx;                     // As registered.
+} systemf1_builtin_call;
+typedef int (*systemf1_builtin_fn)(const systemf1_builtin_call *call);
+extern int systemf1_register_builtin(const char *name, systemf1_builtin_fn fn, void *ctx);
+
+/*
+ * Spawn tracing into an in-memory ring buffer of fixed-size records, for sampling
+ * without the cost of printing.  Writers never block or take a lock.
+ *
+ * systemf1_trace_set() starts tracing into a new ring of at least capacity
+ * records, or stops tracing with 0.  Returns -1 if the ring can't be allocated.
+ * Replaced rings are not freed since another thread may still be writing to them.
+ * systemf1_trace_snapshot() copies up to count of the newest records not yet
+ * drained, oldest first, and leaves them in the ring.
+ * systemf1_trace_drain() copies up to count of the records not yet drained, oldest
+ * first, and removes them.  Both return the number of records copied and still
+ * read from the last ring after tracing is stopped.
+ * systemf1_trace_dropped() returns how many records were overwritten before they
+ * were drained or lost to a full ring.
+ */
+enum {
+ SYSTEMF1_TRACE_PARSE = 1,  // Parsing the fmt.  status is -1 if it failed.
+ SYSTEMF1_TRACE_GLOB,       // Expanding the globs of a command.  status is an errno.
+ SYSTEMF1_TRACE_SANDBOX,    // Checking the %p arguments of a command.  status is -1 if one failed.
+ SYSTEMF1_TRACE_FORK,       // Forking a child.  status is an errno.
+ SYSTEMF1_TRACE_EXEC,       // From launching a group until it was reaped.  status is the wait status.
+ SYSTEMF1_TRACE_WAIT,       // Blocked waiting for a group.  status is the wait status.
+};
+typedef struct {
+    unsigned long long start_ns;     // CLOCK_MONOTONIC when the phase started.
+    unsigned long long duration_ns;
+    unsigned long long call_id;      // The same for every record of one call.
+    int phase;                       // SYSTEMF1_TRACE_*.
+    int pid;                         // The child for FORK and the last of the group for EXEC and WAIT.
+    int status;
+    int reserved;
+} systemf1_trace_record;
+extern int systemf1_trace_set(size_t capacity);
+extern size_t systemf1_trace_snapshot(systemf1_trace_record *records, size_t count);
+extern size_t systemf1_trace_drain(systemf1_trace_record *records, size_t count);
+extern unsigned long long systemf1_trace_dropped(void);
+
+/*
+ * Process-wide counters and latency histograms of every call.  Each thread counts
+ * into one of a fixed set of shards, so threads don't contend for the same cache
+ * lines.  systemf1_stats_get() adds up the shards.  systemf1_stats_reset() zeroes
+ * them.  Calls running at the time may be partly counted.
+ *
+ * latency[phase][b] counts the SYSTEMF1_TRACE_* phases that took from 2^b up to
+ * 2^(b + 1) nanoseconds.  Bucket 0 also counts 0 and the last counts anything longer.
+ */
+#define SYSTEMF1_STATS_BUCKETS 40
+typedef struct {
+    unsigned long long calls;            // Calls to any of the systemf1 entry points, per item for batches.
+    unsigned long long tasks;            // Children launched.
+    unsigned long long parse_errors;
+    unsigned long long glob_nomatch;     // Globs that matched nothing.
+    unsigned long long sandbox_denials;  // %p arguments that left the current directory.
+    unsigned long long fork_failures;
+    unsigned long long signaled;         // Groups ended by a signal, including children that failed to exec.
+    unsigned long long latency[SYSTEMF1_TRACE_WAIT + 1][SYSTEMF1_STATS_BUCKETS];
+} systemf1_stats;
+extern void systemf1_stats_get(systemf1_stats *stats);
+extern void systemf1_stats_reset(void);
+
+/*
+ * Routes every allocation systemf makes, including the lexer's and parser's,
+ * through malloc_fn, realloc_fn, and free_fn with ctx as their last argument.
+ * All three must be given, or all NULL to go back to malloc(), realloc(), and
+ * free().  Returns -1 with errno EINVAL otherwise.
+ *
+ * Memory is freed by the allocator that is set when it is freed, so only change
+ * the allocator while no other thread is in systemf and no systemf1_cmd is
+ * allocated.  The environments systemf caches are freed by the old allocator.
+ * glob() still allocates with malloc() since it has no hooks.  So does the
+ * forkserver helper, since the allocator may not work in a forked process.
+ */
+typedef void *(*systemf1_malloc_fn)(size_t size, void *ctx);
+typedef void *(*systemf1_realloc_fn)(void *ptr, size_t size, void *ctx);
+typedef void (*systemf1_free_fn)(void *ptr, void *ctx);
+extern int systemf1_set_allocator(systemf1_malloc_fn malloc_fn, systemf1_realloc_fn realloc_fn,
+                                  systemf1_free_fn free_fn, void *ctx);
+
 /*
  * Debug Flags used with the global systemf1_debug_set() and systemf1_debug_get()
  * Flags starting with SYSTEMF1_DBG_DBG_ only work if systemf is configured with --enhanced-debug
+ *
+ * Debug output goes to the file given to systemf1_debug_file_set(), or stderr if
+ * it is NULL.  Both setters return the previous value and may be called from any
+ * thread at any time.  With no flags set, a call only pays for reading them.
  */
 enum {
  SYSTEMF1_DBG_ERRORS = 0x01,  // Print a debug any time a nonzero value would be returned.
@@ -19,4 +358,8 @@ extern int systemf1_debug_get();
 extern FILE *systemf1_debug_file_set(FILE *file);
 extern FILE *systemf1_debug_file_get();
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* __systemf_h__ */
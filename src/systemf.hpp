@@ -0,0 +1,587 @@
+#ifndef __systemf_hpp__
+#define __systemf_hpp__
+
+/*
+ * Header only C++17 binding of systemf that checks the format at compile time.
+ * Tokens src/lexer.l doesn't accept, the number of arguments, and the type of
+ * each argument against its conversion are all compile errors.  Arguments go to
+ * systemf1_args() in an array, so nothing goes through the varargs.
+ *
+ * C++17 needs the format wrapped so it can be a template argument:
+ *     systemf::run(SYSTEMF1_FMT("/bin/cp %p %p"), from, to);
+ * C++20 takes it as is:
+ *     systemf::run("/bin/cp %p %p", from, to);
+ *
+ * %s, %p, %!p, and %*p take a const char *, std::string, or std::string_view.
+ * %d and %F take an integer type whose values all fit in an int.
+ * %@s and %@p take a container of const char * with std::data() and std::size(),
+ *   or any other range of strings.
+ *
+ * const char *, std::string, and containers of const char * are passed in place.
+ * std::string_view has no NUL, so it is copied, as are the pointers of a range
+ * of strings other than const char *.
+ *
+ * systemf::start() launches the run and returns a systemf::process without
+ * waiting for it.  It copies every argument since the run outlives the call.  In
+ * C++20, a process can be co_awaited from an event loop with wait_on(), or with
+ * systemf::run_async() in one step.
+ */
+
+#include <climits>
+#include <csignal>
+#include <cstddef>
+#include <forward_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#endif
+
+#include "systemf.h"
+
+namespace systemf {
+namespace detail {
+
+enum class kind { string, integer, splice };
+
+struct conversion {
+    std::string_view text;
+    kind type;
+};
+
+constexpr conversion conversions[] = {
+    {"%s", kind::string}, {"%p", kind::string}, {"%!p", kind::string}, {"%*p", kind::string},
+    {"%d", kind::integer}, {"%F", kind::integer}, {"%@s", kind::splice}, {"%@p", kind::splice},
+};
+
+// Longest first, so the longest match wins like it does in flex.
+constexpr std::string_view operators[] = {
+    "2>&1", "2>>", "&>>", "|>>", ">&2", "2>", "&>", ">>", "&&", "||", "|>", ">", "<", "|", ";",
+};
+
+struct format_error {
+    const char *what;  // nullptr when the format is good.
+    std::size_t position;
+};
+
+constexpr bool starts_with(std::string_view s, std::string_view prefix) {
+    return s.substr(0, prefix.size()) == prefix;
+}
+
+constexpr bool is_word(char c) {
+    return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) ||
+           (c == '/') || (c == '_') || (c == '.') || (c == '-');
+}
+
+/*
+ * Walks fmt the way src/lexer.l splits it into tokens and calls on_conversion
+ * with the kind of each conversion.  Returns the first thing the lexer would
+ * hand the parser as a character it has no rule for.
+ */
+template <typename F>
+constexpr format_error scan(std::string_view fmt, F &&on_conversion) {
+    std::size_t i = 0;
+
+    while (i < fmt.size()) {
+        std::string_view rest = fmt.substr(i);
+        std::size_t matched = 0;
+
+        if (rest[0] == '%') {
+            for (const conversion &c : conversions) {
+                if (starts_with(rest, c.text)) {
+                    on_conversion(c.type);
+                    matched = c.text.size();
+                    break;
+                }
+            }
+            if (!matched) {
+                return {"unknown conversion", i};
+            }
+        }
+        for (std::size_t o = 0; !matched && (o < std::size(operators)); o++) {
+            if (starts_with(rest, operators[o])) {
+                matched = operators[o].size();
+            }
+        }
+        if (matched) {
+            // Done.
+        } else if (is_word(rest[0])) {
+            while ((matched < rest.size()) && is_word(rest[matched])) {
+                matched++;
+            }
+        } else if ((rest[0] == '*') || (rest[0] == '?') || (rest[0] == ' ') || (rest[0] == '\t')) {
+            matched = 1;
+        } else if (rest[0] == '[') {
+            std::size_t end = 1;
+            while ((end < rest.size()) && is_word(rest[end])) {
+                end++;
+            }
+            if ((end == 1) || (end == rest.size()) || (rest[end] != ']')) {
+                return {"'[' that isn't a glob like [abc]", i};
+            }
+            matched = end + 1;
+        } else {
+            return {"character systemf doesn't accept", i};
+        }
+        i += matched;
+    }
+    return {nullptr, 0};
+}
+
+template <typename T>
+using bare_t = std::remove_cv_t<std::remove_reference_t<T>>;
+
+template <typename T, typename U = bare_t<T>>
+constexpr bool is_string_v = (std::is_convertible_v<T, const char *> && !std::is_same_v<U, std::nullptr_t>) ||
+                             std::is_same_v<U, std::string> || std::is_same_v<U, std::string_view>;
+
+template <typename U, bool = std::is_integral_v<U>>
+struct fits_int : std::false_type {};
+template <typename U>
+struct fits_int<U, true>
+    : std::bool_constant<(static_cast<long long>(std::numeric_limits<U>::min()) >= INT_MIN) &&
+                         (static_cast<unsigned long long>(std::numeric_limits<U>::max()) <= INT_MAX)> {};
+
+// Only types that can't hold a value an int can't.  char is more likely a mistake.
+template <typename T, typename U = bare_t<T>>
+constexpr bool is_int_v = fits_int<U>::value && !std::is_same_v<U, bool> && !std::is_same_v<U, char> &&
+                          !std::is_same_v<U, wchar_t> && !std::is_same_v<U, char16_t> &&
+                          !std::is_same_v<U, char32_t>;
+
+template <typename T, typename = void>
+struct is_pointer_list : std::false_type {};
+template <typename T>
+struct is_pointer_list<T, std::void_t<decltype(std::size(std::declval<T &>())),
+                                      decltype(std::data(std::declval<T &>()))>>
+    : std::is_convertible<decltype(std::data(std::declval<T &>())), const char *const *> {};
+
+template <typename T, typename = void>
+struct is_string_range : std::false_type {};
+template <typename T>
+struct is_string_range<T, std::void_t<decltype(std::begin(std::declval<T &>())),
+                                      decltype(std::end(std::declval<T &>()))>>
+    : std::bool_constant<is_string_v<decltype(*std::begin(std::declval<T &>()))>> {};
+
+template <typename T>
+constexpr bool is_splice_v = is_pointer_list<bare_t<T>>::value || is_string_range<bare_t<T>>::value;
+
+template <typename T>
+constexpr bool accepts(kind k) {
+    switch (k) {
+    case kind::string:
+        return is_string_v<T>;
+    case kind::integer:
+        return is_int_v<T>;
+    default:
+        return is_splice_v<T>;
+    }
+}
+
+enum class status { ok, bad_token, bad_count, bad_type };
+
+template <typename... Args>
+constexpr status validate(std::string_view fmt) {
+    kind kinds[sizeof...(Args) + 1] = {};
+    std::size_t count = 0;
+    [[maybe_unused]] std::size_t i = 0;
+
+    if (scan(fmt, [&](kind k) {
+            if (count < sizeof...(Args)) {
+                kinds[count] = k;
+            }
+            count++;
+        }).what) {
+        return status::bad_token;
+    }
+    if (count != sizeof...(Args)) {
+        return status::bad_count;
+    }
+    return (accepts<Args>(kinds[i++]) && ...) ? status::ok : status::bad_type;
+}
+
+// systemf1_arg entries for Args.  %@s and %@p take two.
+template <typename... Args>
+constexpr std::size_t slots = ((is_splice_v<Args> ? 2 : 1) + ... + 0);
+
+/*
+ * Keeps the NUL terminated copies a call needs until it returns, or a started
+ * run needs until it finishes.  Nothing is allocated unless a copy is needed.
+ */
+struct copies {
+    std::forward_list<std::string> strings;
+    std::forward_list<std::vector<const char *>> lists;
+};
+
+// With Own, every string is copied since the caller's may be gone before the run finishes.
+template <bool Own, typename T>
+const char *c_str(T &&arg, copies &kept) {
+    using U = bare_t<T>;
+    if constexpr (std::is_same_v<U, std::string_view> || (Own && !std::is_convertible_v<T, const char *>)) {
+        return kept.strings.emplace_front(arg).c_str();
+    } else if constexpr (Own) {
+        const char *s = arg;
+        return s ? kept.strings.emplace_front(s).c_str() : nullptr;
+    } else if constexpr (std::is_same_v<U, std::string>) {
+        return arg.c_str();
+    } else {
+        return arg;
+    }
+}
+
+template <bool Own, typename T>
+void put(systemf1_arg *&out, T &&arg, copies &kept) {
+    using U = bare_t<T>;
+    if constexpr (is_int_v<T>) {
+        (out++)->d = static_cast<int>(arg);
+    } else if constexpr (is_string_v<T>) {
+        (out++)->s = c_str<Own>(arg, kept);
+    } else if constexpr (!Own && is_pointer_list<U>::value) {
+        (out++)->sv = std::data(arg);
+        (out++)->n = std::size(arg);
+    } else {
+        std::vector<const char *> &pointers = kept.lists.emplace_front();
+        for (auto &&s : arg) {
+            pointers.push_back(c_str<Own>(s, kept));
+        }
+        (out++)->sv = pointers.data();
+        (out++)->n = pointers.size();
+    }
+}
+
+/*
+ * Calls f with the systemf1_arg array and count for args.
+ */
+template <bool Own, typename F, typename... Args>
+auto with_args(copies &kept, F &&f, Args &&...args) {
+    systemf1_arg array[slots<Args...> + 1] = {};
+    systemf1_arg *out = array;
+
+    (put<Own>(out, std::forward<Args>(args), kept), ...);
+    return f(array, static_cast<std::size_t>(out - array));
+}
+
+template <typename... Args>
+int call(const systemf1_opts *opts, const char *fmt, Args &&...args) {
+    copies kept;
+
+    return with_args<false>(kept, [&](const systemf1_arg *array, std::size_t n) {
+        return systemf1_args(opts, fmt, array, n);
+    }, std::forward<Args>(args)...);
+}
+
+/*
+ * What a started run keeps until it finishes.
+ */
+struct owned {
+    copies kept;
+    systemf1_opts opts;
+};
+
+template <typename T, typename = void>
+struct is_fmt : std::false_type {};
+template <typename T>
+struct is_fmt<T, std::void_t<decltype(T::value())>> : std::is_convertible<decltype(T::value()), const char *> {};
+
+/*
+ * What a call site needs from its format, worked out once at compile time.
+ */
+struct plan {
+    const char *fmt;
+    status checked;
+};
+
+template <typename Fmt, typename... Args>
+const char *checked() {
+    static constexpr plan site = {Fmt::value(), validate<Args...>(Fmt::value())};
+
+    static_assert(site.checked != status::bad_token, "systemf: the format has a token systemf doesn't accept");
+    static_assert(site.checked != status::bad_count, "systemf: the format has a different number of conversions than arguments");
+    static_assert(site.checked != status::bad_type, "systemf: an argument's type doesn't match its conversion");
+    return site.fmt;
+}
+
+}  // namespace detail
+
+/*
+ * A format that is a type, for C++17.  Use it directly in the call.
+ */
+#define SYSTEMF1_FMT(fmt) \
+    ([] { \
+        struct systemf1_fmt_ { \
+            static constexpr const char *value() { return fmt; } \
+        }; \
+        return systemf1_fmt_{}; \
+    }())
+
+template <typename Fmt, typename... Args, typename = std::enable_if_t<detail::is_fmt<Fmt>::value>>
+int run(Fmt, Args &&...args) {
+    return detail::call(nullptr, detail::checked<Fmt, Args...>(), std::forward<Args>(args)...);
+}
+
+template <typename Fmt, typename... Args, typename = std::enable_if_t<detail::is_fmt<Fmt>::value>>
+int run_ex(const systemf1_opts &opts, Fmt, Args &&...args) {
+    return detail::call(&opts, detail::checked<Fmt, Args...>(), std::forward<Args>(args)...);
+}
+
+/*
+ * A run from systemf::start() that hasn't been waited for.  Destroying it while
+ * the run is still going kills it with SIGKILL and reaps it, which waits for a
+ * builtin to return (see systemf1_builtin_call's cancel).  Movable but not
+ * copyable.  A process that failed to start is finished with a result of -1.
+ *
+ * poll() returns the result once the run has finished and launches what runs
+ * next without blocking.  Call it each time fd() is readable.
+ */
+class process {
+public:
+    process() noexcept = default;
+
+    explicit process(systemf1_proc *proc, std::unique_ptr<detail::owned> kept = nullptr) noexcept
+        : proc_(proc), kept_(std::move(kept)) {}
+
+    process(process &&other) noexcept
+        : proc_(std::exchange(other.proc_, nullptr)), kept_(std::move(other.kept_)) {}
+
+    process &operator=(process &&other) noexcept {
+        if (this != &other) {
+            systemf1_proc_free(proc_);
+            proc_ = std::exchange(other.proc_, nullptr);
+            kept_ = std::move(other.kept_);
+        }
+        return *this;
+    }
+
+    process(const process &) = delete;
+    process &operator=(const process &) = delete;
+
+    ~process() {
+        // Before the arguments in kept_ it may still use.
+        systemf1_proc_free(proc_);
+    }
+
+    explicit operator bool() const noexcept {
+        return proc_ != nullptr;
+    }
+
+    int fd() const noexcept {
+        return proc_ ? systemf1_proc_fd(proc_) : -1;
+    }
+
+    std::optional<int> poll() noexcept {
+        int result = -1;
+
+        if (proc_ && systemf1_proc_poll(proc_, &result)) {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    int wait() noexcept {
+        return proc_ ? systemf1_proc_wait(proc_) : -1;
+    }
+
+    bool kill(int sig = SIGTERM) noexcept {
+        return proc_ && !systemf1_proc_kill(proc_, sig);
+    }
+
+    systemf1_proc *native_handle() const noexcept {
+        return proc_;
+    }
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+    template <typename Loop>
+    auto wait_on(Loop &loop) &;
+#endif
+
+private:
+    systemf1_proc *proc_ = nullptr;
+    std::unique_ptr<detail::owned> kept_;
+};
+
+namespace detail {
+template <typename... Args>
+process start(const systemf1_opts *opts, const char *fmt, Args &&...args) {
+    auto kept = std::make_unique<owned>();
+    systemf1_proc *proc;
+
+    // The arguments and opts are copied, but not what opts points to.
+    if (opts) {
+        kept->opts = *opts;
+        opts = &kept->opts;
+    }
+    proc = with_args<true>(kept->kept, [&](const systemf1_arg *array, std::size_t n) {
+        return systemf1_start_args(opts, fmt, array, n);
+    }, std::forward<Args>(args)...);
+    return process(proc, std::move(kept));
+}
+}  // namespace detail
+
+template <typename Fmt, typename... Args, typename = std::enable_if_t<detail::is_fmt<Fmt>::value>>
+process start(Fmt, Args &&...args) {
+    return detail::start(nullptr, detail::checked<Fmt, Args...>(), std::forward<Args>(args)...);
+}
+
+template <typename Fmt, typename... Args, typename = std::enable_if_t<detail::is_fmt<Fmt>::value>>
+process start_ex(const systemf1_opts &opts, Fmt, Args &&...args) {
+    return detail::start(&opts, detail::checked<Fmt, Args...>(), std::forward<Args>(args)...);
+}
+
+/*
+ * Whether fmt would be accepted with arguments of types Args, for tests and
+ * static_assert().
+ */
+template <typename... Args>
+constexpr bool accepts(std::string_view fmt) {
+    return detail::validate<Args...>(fmt) == detail::status::ok;
+}
+
+#if defined(__cpp_consteval) && defined(__cpp_lib_type_identity)
+namespace detail {
+// Never defined.  Calling one of these in a consteval function is the compile error.
+void format_has_a_token_systemf_does_not_accept();
+void format_has_a_different_number_of_conversions_than_arguments();
+void argument_type_does_not_match_its_conversion();
+}  // namespace detail
+
+/*
+ * A format literal checked against Args when it is converted, like
+ * std::format_string.
+ */
+template <typename... Args>
+class format_string {
+public:
+    template <std::size_t N>
+    consteval format_string(const char (&fmt)[N]) : fmt_(fmt) {
+        switch (detail::validate<Args...>(std::string_view(fmt, N - 1))) {
+        case detail::status::bad_token:
+            detail::format_has_a_token_systemf_does_not_accept();
+            break;
+        case detail::status::bad_count:
+            detail::format_has_a_different_number_of_conversions_than_arguments();
+            break;
+        case detail::status::bad_type:
+            detail::argument_type_does_not_match_its_conversion();
+            break;
+        default:
+            break;
+        }
+    }
+
+    const char *get() const {
+        return fmt_;
+    }
+
+private:
+    const char *fmt_;
+};
+
+template <typename... Args>
+int run(format_string<std::type_identity_t<Args>...> fmt, Args &&...args) {
+    return detail::call(nullptr, fmt.get(), std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+int run_ex(const systemf1_opts &opts, format_string<std::type_identity_t<Args>...> fmt, Args &&...args) {
+    return detail::call(&opts, fmt.get(), std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+process start(format_string<std::type_identity_t<Args>...> fmt, Args &&...args) {
+    return detail::start(nullptr, fmt.get(), std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+process start_ex(const systemf1_opts &opts, format_string<std::type_identity_t<Args>...> fmt, Args &&...args) {
+    return detail::start(&opts, fmt.get(), std::forward<Args>(args)...);
+}
+#endif
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+/*
+ * co_await on a process resumes with its result once it finishes, without a
+ * thread per child.  loop is the caller's event loop (epoll, io_uring, ...).  It
+ * needs
+ *     loop.watch(int fd, F callback)
+ * to call callback() once the next time fd is readable.  The coroutine is
+ * resumed from inside callback().  Without pidfds there is no fd, so the wait
+ * blocks.
+ *
+ * The callback points at the awaitable, and the loop has no way to drop it.  So
+ * neither the process nor the awaiting coroutine may be destroyed while it is
+ * suspended.  To stop early, kill the process and let the coroutine resume.
+ *
+ * P is process for an awaitable that owns its process and process & otherwise.
+ */
+template <typename Loop, typename P>
+class awaitable {
+public:
+    awaitable(Loop &loop, P proc) : loop_(loop), proc_(std::forward<P>(proc)) {}
+
+    bool await_ready() {
+        result_ = proc_.poll();
+        if (!result_ && (proc_.fd() < 0)) {
+            result_ = proc_.wait();
+        }
+        return result_.has_value();
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        handle_ = handle;
+        arm();
+    }
+
+    int await_resume() const noexcept {
+        return *result_;
+    }
+
+private:
+    void arm() {
+        loop_.watch(proc_.fd(), [this] {
+            result_ = proc_.poll();
+            if (result_) {
+                handle_.resume();
+            } else {
+                arm();
+            }
+        });
+    }
+
+    Loop &loop_;
+    P proc_;
+    std::optional<int> result_;
+    std::coroutine_handle<> handle_;
+};
+
+template <typename Loop>
+auto process::wait_on(Loop &loop) & {
+    return awaitable<Loop, process &>(loop, *this);
+}
+
+/*
+ * int result = co_await systemf::run_async(loop, fmt, args...);
+ * The awaiting coroutine must not be destroyed while it is suspended.
+ */
+#if defined(__cpp_consteval) && defined(__cpp_lib_type_identity)
+template <typename Loop, typename... Args>
+awaitable<Loop, process> run_async(Loop &loop, format_string<std::type_identity_t<Args>...> fmt, Args &&...args) {
+    return {loop, detail::start(nullptr, fmt.get(), std::forward<Args>(args)...)};
+}
+
+template <typename Loop, typename... Args>
+awaitable<Loop, process> run_async_ex(Loop &loop, const systemf1_opts &opts,
+                                      format_string<std::type_identity_t<Args>...> fmt, Args &&...args) {
+    return {loop, detail::start(&opts, fmt.get(), std::forward<Args>(args)...)};
+}
+#endif
+#endif
+
+}  // namespace systemf
+
+#endif /* __systemf_hpp__ */
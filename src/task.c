@@ -1,3 +1,4 @@
+#define _GNU_SOURCE // F_SETPIPE_SZ.
 #include <stdlib.h>
 #include <unistd.h>
 #include <glob.h>
@@ -6,11 +7,16 @@
 #include <stdio.h>
 #include <assert.h>
 #include <signal.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <fcntl.h>
+#include <limits.h>
 #include "systemf-internal.h"
 
+extern char **environ;
+
 #define DEBUG 0
 #define VA_ARGS(...) , ##__VA_ARGS__
 #define DBG(fmt, ...) if (DEBUG) { printf("%s:%-3d:%24s: " fmt "\n", __FILE__, __LINE__, __FUNCTION__ VA_ARGS(__VA_ARGS__)); }
@@ -21,7 +27,7 @@ typedef struct glob_list_ {
 } glob_list;
 
 _sf1_task *_sf1_task_create() {
-    return calloc(1, sizeof(_sf1_task));
+    return _sf1_calloc(1, sizeof(_sf1_task));
 }
 
 /*
@@ -57,12 +63,13 @@ _sf1_task_arg *_sf1_task_add_arg (_sf1_task *task, char *text, char *trusted_pat
 {
     _sf1_task_arg *arg;
 
-    arg = calloc(1, sizeof(_sf1_task_arg));
+    arg = _sf1_calloc(1, sizeof(_sf1_task_arg));
     if (arg == NULL) {
         return NULL;
     }
 
     arg->text = text;
+    arg->owns_text = 1;
     arg->trusted_path = trusted_path;
     arg->is_glob = is_glob;
 
@@ -87,6 +94,7 @@ char *_sf1_stream_name(_sf1_stream stream) {
         case _SF1_STDERR: return "stderr"; break;
         case _SF1_PIPE: return "pipe"; break;
         case _SF1_FILE: return "file"; break;
+        case _SF1_FD: return "fd"; break;
         default: assert(0);
     }
 }
@@ -138,11 +146,12 @@ int _sf1_redirects_are_sane(_sf1_task *tasks)
  *   GLOB_ABORTED for a read error, and
  *   GLOB_NOMATCH for when the number of matches doesn't match the specified allowed match count.
  */
-int _sf1_extract_glob(_sf1_task *task)
+int _sf1_extract_glob(_sf1_task *task, int dirfd)
 {
     for (_sf1_task_arg *a = task->args; a != NULL; a = a->next) {
         if (a->is_glob) {
-            int ret = glob(a->text, 0, NULL, &a->glob);
+            int ret = _sf1_glob_at(dirfd, a->text, &a->glob);
+            _SF1_PROBE(glob, a->text, ret, a->glob.gl_pathc);
             // FIXME: do a bounds check.
             switch (ret) {
             case GLOB_NOSPACE:
@@ -152,6 +161,7 @@ int _sf1_extract_glob(_sf1_task *task)
                 fprintf(stderr, "systemf: glob aborted during extraction: %s\n", a->text);
                 return EBADF;
             case GLOB_NOMATCH:
+                _SF1_STAT(glob_nomatch);
                 fprintf(stderr, "systemf: no matches found: %s\n", a->text);
                 return EINVAL;
             }
@@ -160,6 +170,41 @@ int _sf1_extract_glob(_sf1_task *task)
     return 0;
 }
 
+void _sf1_redirects_free(_sf1_redirect *redirect)
+{
+    _sf1_redirect *next;
+    for (; redirect != NULL; redirect = next) {
+        _sf1_free(redirect->text);
+        _sf1_free(redirect->trusted_path);
+        _sf1_syllables_free(redirect->file);
+        next = redirect->next;
+        _sf1_free(redirect);
+    }
+}
+
+/*
+ * Copies the arguments that still point at the caller's strings, so the tasks
+ * can run after the call that parsed them has returned.  Returns -1 if memory
+ * runs out.  The arguments copied so far are freed with the tasks.
+ */
+int _sf1_task_own_args(_sf1_task *task)
+{
+    for (; task != NULL; task = task->next) {
+        for (_sf1_task_arg *a = task->args; a != NULL; a = a->next) {
+            if (!a->owns_text) {
+                char *text = _sf1_strdup(a->text);
+
+                if (!text) {
+                    return -1;
+                }
+                a->text = text;
+                a->owns_text = 1;
+            }
+        }
+    }
+    return 0;
+}
+
 void _sf1_task_free(_sf1_task *task)
 {
     _sf1_task *next;
@@ -167,84 +212,216 @@ void _sf1_task_free(_sf1_task *task)
         _sf1_task_arg *anext;
         for (_sf1_task_arg *a = task->args; a != NULL; a = anext) {
             globfree(&a->glob);
-            free(a->text);
-            free(a->trusted_path);
+            if (a->owns_text) {
+                _sf1_free(a->text);
+            }
+            _sf1_free(a->trusted_path);
+            _sf1_syllables_free(a->word);
             anext = a->next;
-            free(a);
+            _sf1_free(a);
         }
 
-        _sf1_redirect *rnext;
-        for (_sf1_redirect *r = task->redirects; r != NULL; r = rnext) {
-            free(r->text);
-            free(r->trusted_path);
-            rnext = r->next;
-            free(r);
-        }
-
-        free(task->argv);
+        _sf1_redirects_free(task->redirects);
+        _sf1_free(task->argv);
         next = task->next;
-        free(task);
+        _sf1_free(task);
     }
     return;
 }
 
+/*
+ * Close the child in out and error if they aren't shared with the parent.
+ */
+void _sf1_close_child_files(_sf1_task_files *files) {
+    if ((files->in > 2) && !(files->caller_owned & (1 << 0))) {
+        close(files->in);
+    }
+    if ((files->out > 2) && !(files->caller_owned & (1 << 1))) {
+        close(files->out);
+    }
+    // 2>&1 and >&2 leave both streams on one fd.
+    if ((files->err > 2) && (files->err != files->out) && !(files->caller_owned & (1 << 2))) {
+        close(files->err);
+    }
+    files->in = 0;
+    files->out = 1;
+    files->err = 2;
+    files->caller_owned = 0;
+}
+
+/*
+ * Close the child in out, error, and pipe.
+ */
+void _sf1_close_child_files_and_pipe(_sf1_task_files *files) {
+    if (files->out_rd_pipe) {
+        close(files->out_rd_pipe);
+        files->out_rd_pipe = 0;
+    }
+    _sf1_close_child_files(files);
+}
+
+/*
+ * Returns the caller's fd to use as child_fd in the child and marks it as the
+ * caller's so it isn't closed.  Returns -1 if fd isn't open.
+ *
+ * The child dup2()s its files onto 0, 1, and 2 in turn, so one of those going to
+ * a different child fd could be replaced before it is used.  It is given a copy
+ * above 2 instead, which is closed like an opened file.
+ */
+static int _sf1_caller_fd(_sf1_task_files *files, int child_fd, int fd) {
+    if (fcntl(fd, F_GETFD) < 0) {
+        fprintf(stderr, "systemf: %s: fd %d\n", strerror(errno), fd);
+        return -1;
+    }
+    if ((fd <= 2) && (fd != child_fd)) {
+        int copy = fcntl(fd, F_DUPFD_CLOEXEC, 3);
+
+        if (copy < 0) {
+            fprintf(stderr, "systemf: %s: fd %d\n", strerror(errno), fd);
+        }
+        return copy;
+    }
+    files->caller_owned |= 1 << child_fd;
+    return fd;
+}
+
+/*
+ * Sets the capacity of the pipe fd to size, capped at /proc/sys/fs/pipe-max-size.
+ * Failing isn't an error.  The pipe just keeps the capacity it has.
+ */
+static void _sf1_pipe_resize(int fd, int size) {
+#ifdef F_SETPIPE_SZ
+    static int max_size = 0; // -1 once it's known it can't be read.
+    int max = __atomic_load_n(&max_size, __ATOMIC_RELAXED);
+
+    if (!max) {
+        FILE *f = fopen("/proc/sys/fs/pipe-max-size", "re");
+
+        if (!f || (fscanf(f, "%d", &max) != 1) || (max <= 0)) {
+            max = -1;
+        }
+        if (f) {
+            fclose(f);
+        }
+        __atomic_store_n(&max_size, max, __ATOMIC_RELAXED);
+    }
+    if ((max > 0) && (size > max)) {
+        size = max;
+    }
+    if (fcntl(fd, F_SETPIPE_SZ, size) < 0) {
+        DBG("F_SETPIPE_SZ %d: %s", size, strerror(errno));
+    }
+#else
+    (void) fd;
+    (void) size;
+#endif
+}
+
 /*
  * Fills in the files for the tasks.
  * 
- * Returns -1 on failure and 0 on success.
+ * Returns -1 on failure and 0 on success.  On failure, everything opened is
+ * closed, including the read end of the previous task's pipe.
  */
-int _sf1_populate_task_files(_sf1_task *task, _sf1_task_files *files) {
+int _sf1_populate_task_files(_sf1_task *task, _sf1_task_files *files, int dirfd, int pipe_size) {
     int pipefd[2];
     _sf1_redirect *redirect;
     int rwrwrw = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
     int prev_out_rd_pipe = files->out_rd_pipe;
+    int out_shares = 0;   // ">&2"
+    int err_shares = 0;   // "2>&1"
 
     files->in = 0;
     files->out = 1;
     files->err = 2;
     files->out_rd_pipe = 0;
+    files->caller_owned = 0;
 
     for (redirect = task->redirects; redirect; redirect = redirect->next) {
         if (redirect->stream == _SF1_STDIN)  {
             if (redirect->target == _SF1_FILE) {
-                files->in = open(redirect->text, O_RDONLY);
+                files->in = openat(dirfd, redirect->text, O_RDONLY);
                 if (files->in < 0) {
                     fprintf(stderr, "systemf: %s: %s\n", strerror(errno), redirect->text);
-                    return -1;
+                    goto error;
+                }
+            } else if (redirect->target == _SF1_FD) {
+                files->in = _sf1_caller_fd(files, 0, redirect->fd);
+                if (files->in < 0) {
+                    goto error;
                 }
             } else { // _SF1_PIPE
                 files->in = prev_out_rd_pipe;
             }
         } else if (redirect->stream == _SF1_STDOUT) {
+            out_shares = 0;
             if (redirect->target == _SF1_FILE) {
-                files->out = open(redirect->text, O_WRONLY | O_CREAT | (redirect->append ? O_APPEND : O_TRUNC), rwrwrw);
+                files->out = openat(dirfd, redirect->text, O_WRONLY | O_CREAT | (redirect->append ? O_APPEND : O_TRUNC), rwrwrw);
                 if (files->out < 0) {
                     fprintf(stderr, "systemf: %s: %s\n", strerror(errno), redirect->text);
-                    return -1;
+                    goto error;
+                }
+            } else if (redirect->target == _SF1_FD) {
+                files->out = _sf1_caller_fd(files, 1, redirect->fd);
+                if (files->out < 0) {
+                    goto error;
                 }
             } else if (redirect->target == _SF1_SHARE) {
-                files->out = files->err;
+                out_shares = 1;
             } else { // _SF1_PIPE
                 if (pipe(pipefd)) {
                     fprintf(stderr, "systemf: %s opening a pipe\n", strerror(errno));
-                    return -1;
+                    goto error;
+                }
+                if (pipe_size) {
+                    _sf1_pipe_resize(pipefd[1], pipe_size);
                 }
                 files->out_rd_pipe = pipefd[0];
                 files->out = pipefd[1];
             }
         } else { // _SF1_STDERR
+            err_shares = 0;
             if (redirect->target == _SF1_FILE) {
-                files->err = open(redirect->text, O_WRONLY | O_CREAT | (redirect->append ? O_APPEND : O_TRUNC), rwrwrw);
+                files->err = openat(dirfd, redirect->text, O_WRONLY | O_CREAT | (redirect->append ? O_APPEND : O_TRUNC), rwrwrw);
                 if (files->err < 0) {
                     fprintf(stderr, "systemf: %s: %s\n\n", strerror(errno), redirect->text);
-                    return -1;
+                    goto error;
+                }
+            } else if (redirect->target == _SF1_FD) {
+                files->err = _sf1_caller_fd(files, 2, redirect->fd);
+                if (files->err < 0) {
+                    goto error;
                 }
             } else if (redirect->target == _SF1_SHARE) {
-                files->err = files->out;
+                err_shares = 1;
             }
         }
     }
+
+    /*
+     * A shared stream gets the other one's final file wherever its redirect is,
+     * so "&>file" and "2>&1 | b" mean the same for a child, which dup2()s out
+     * before err, and for the forkserver and builtins, which use the fds as is.
+     */
+    if (err_shares) {
+        files->err = files->out;
+        if (files->caller_owned & (1 << 1)) {
+            files->caller_owned |= 1 << 2;
+        }
+    } else if (out_shares) {
+        files->out = files->err;
+        if (files->caller_owned & (1 << 2)) {
+            files->caller_owned |= 1 << 1;
+        }
+    }
     return 0;
+
+error:
+    if (prev_out_rd_pipe && (files->in != prev_out_rd_pipe)) {
+        close(prev_out_rd_pipe);
+    }
+    _sf1_close_child_files_and_pipe(files);
+    return -1;
 }
 
 /*
@@ -276,54 +453,110 @@ int _sf1_file_sandbox_check_args(_sf1_task *task) {
 
 
 /*
- * Close the child in out and error if they aren't shared with the parent.
+ * Returns 1 if the task's stdout is piped into the next task.
  */
-void _sf1_close_child_files(_sf1_task_files *files) {
-    if (files->in > 2) {
-        close(files->in);
-        files->in = 0;
-    }
-    if (files->out > 2) {
-        close(files->out);
-        files->out = 1;
+static int _sf1_task_pipes_out(_sf1_task *task) {
+    for (_sf1_redirect *r = task->redirects; r; r = r->next) {
+        if ((r->stream == _SF1_STDOUT) && (r->target == _SF1_PIPE)) {
+            return 1;
+        }
     }
-    if (files->err > 2) {
-        close(files->err);
-        files->err = 2;
+    return 0;
+}
+
+/*
+ * Counts the children forked for the tasks up to and including the next task
+ * that isn't piped.
+ */
+static int _sf1_group_size(_sf1_task *task) {
+    _sf1_builtin builtin;
+    int size = 0;
+
+    for (; task; task = task->next) {
+        // Tees and builtins are threads of the caller, not children.
+        int thread = task->is_tee ||
+                     (task->args && !task->args->is_glob && _sf1_builtin_find(task->args->text, &builtin));
+
+        size += !thread;
+        if (!_sf1_task_pipes_out(task)) {
+            break;
+        }
     }
+    return size;
 }
 
 /*
- * Close the child in out, error, and pipe.
+ * Prepares a run of the chain of tasks.
+ * Returns -1 if the tasks can't be run and 0 on success.
  */
-void _sf1_close_child_files_and_pipe(_sf1_task_files *files) {
-    if (files->out_rd_pipe) {
-        close(files->out_rd_pipe);
-        files->out_rd_pipe = 0;
+int _sf1_run_init(_sf1_run *run, _sf1_task *tasks) {
+    run->tasks = tasks;
+    run->next_task = tasks;
+    run->wait_task = NULL;
+    run->pid_chain = NULL;
+    run->files = (_sf1_task_files) {.in=0, .out=1, .err=2, .out_rd_pipe=0, .caller_owned=0};
+    run->envp = environ;
+    run->dirfd = AT_FDCWD;
+    run->cgroup_fd = -1;
+    run->limits = NULL;
+    run->pipe_size = 0;
+    run->call_id = 0;
+    run->launched_ns = 0;
+    run->admitted = 0;
+    run->defer_admission = 0;
+    run->env = NULL;
+    run->dirfd_owned = 0;
+    run->retval = -1;
+
+    if (!_sf1_redirects_are_sane(tasks)) {
+        return -1;
     }
-    _sf1_close_child_files(files);
+
+    return 0;
 }
 
-int _sf1_tasks_run(_sf1_task *tasks) {
+/*
+ * Launches tasks up to and including the next task that isn't piped into
+ * another.  The launched pids are in run->pid_chain.
+ *
+ * The whole group is admitted before anything is launched.  If it can't be
+ * admitted and run->defer_admission is set, nothing is launched and
+ * _SF1_RUN_DEFERRED is returned so the launch can be tried again later.
+ *
+ * Returns 1 if pids were launched and need reaping, 0 if there is nothing
+ * left to run, and -1 on failure.
+ */
+int _sf1_run_launch(_sf1_run *run) {
     pid_t pid;
-    _sf1_pid_chain_t *pid_chain = NULL;
-    int stat;
     char **argv;
+    _sf1_pid_chain_t *pid_chain;
     _sf1_task_arg *arg;
-    size_t argc = 1; // 1 for terminating NULL
     int ret;
-    int retval = -1;
-    _sf1_task_files files = {.in=0, .out=1, .err=2, .out_rd_pipe=0};
+    _sf1_task_files *files = &run->files;
+    _sf1_spawn spawn;
+    _sf1_builtin builtin;
 
-    if (!_sf1_redirects_are_sane(tasks)) {
-        goto exit_error;
+    if (run->next_task && !run->admitted) {
+        int size = _sf1_group_size(run->next_task);
+
+        if (size && _sf1_admission_acquire(size, run->defer_admission)) {
+            if (run->defer_admission) {
+                return _SF1_RUN_DEFERRED;
+            }
+            fprintf(stderr, "systemf: %s admitting %d children\n", strerror(errno), size);
+            goto exit_error;
+        }
+        run->admitted = size;
     }
 
-     // We don't support tasks reuse, so argv MUST be null coming into this.
-    assert(tasks->argv == NULL);
+    run->launched_ns = _sf1_now_ns();
+
+    for (_sf1_task *task = run->next_task; task; task = task->next) {
+        size_t argc = 1; // 1 for terminating NULL
+        unsigned long long start = _sf1_now_ns();
 
-    for (_sf1_task *task = tasks; task; task = task->next) {
-        ret = _sf1_extract_glob(task);
+        ret = _sf1_extract_glob(task, run->dirfd);
+        _sf1_phase_end(run->call_id, SYSTEMF1_TRACE_GLOB, start, 0, ret);
         if (ret) {
             errno = ret;
             goto exit_error;
@@ -338,12 +571,19 @@ int _sf1_tasks_run(_sf1_task *tasks) {
             }
         }
 
-        if (_sf1_file_sandbox_check_args(task)) {
+        start = _sf1_now_ns();
+        ret = _sf1_file_sandbox_check_args(task);
+        _sf1_phase_end(run->call_id, SYSTEMF1_TRACE_SANDBOX, start, 0, ret);
+        if (ret) {
+            _SF1_STAT(sandbox_denials);
             goto exit_error;
         }
 
-        task->argv = malloc(argc * sizeof(char *));
-        // FIXME: handle NULL
+        task->argv = _sf1_malloc(argc * sizeof(char *));
+        if (!task->argv) {
+            fprintf(stderr, "systemf: argv out of memory\n");
+            goto exit_error;
+        }
 
         argv = task->argv;
         for (arg = task->args; arg != NULL; arg = arg->next) {
@@ -356,9 +596,14 @@ int _sf1_tasks_run(_sf1_task *tasks) {
             }
         }
         *argv = NULL;
+        if (!task->argv[0]) {
+            fprintf(stderr, "systemf: a command has no arguments\n");
+            errno = EINVAL;
+            goto exit_error;
+        }
         DBG("_____________________ err exi exs sig tsig\n");
 
-        if (_sf1_populate_task_files(task, &files)) {
+        if (_sf1_populate_task_files(task, files, run->dirfd, run->pipe_size)) {
             goto exit_error;
         }
 
@@ -369,73 +614,218 @@ int _sf1_tasks_run(_sf1_task *tasks) {
         // FIXME: Determine if the file exists and it is executable before attempting
         // to fork which doesn't know how to handle results.
 
-        pid = fork();
-        if (pid == 0) {
-            dup2(files.in, 0);
-            dup2(files.out, 1);
-            dup2(files.err, 2);
-            _sf1_close_upper_fd();
-
-            DBG("Running %s", task->argv[0]);
-            stat = execv(*task->argv, task->argv);
-            DBG("Execv   returned with %3d %3d %3d %3d %3d\n", errno,
-                WIFEXITED(stat), WEXITSTATUS(stat), WIFSIGNALED(stat), WTERMSIG(stat));
-
-            // If execv exits, we don't have an easy way to send the results back other
-            // than some extra socket.  Instead we should try catching all exceptions
-            // (file not found, file not executable) before forking.  Kill thyself.
-            kill(getpid(), SIGKILL);
+        spawn = (_sf1_spawn) {
+            .argv = task->argv,
+            .envp = run->envp,
+            .in = files->in,
+            .out = files->out,
+            .err = files->err,
+            .dirfd = run->dirfd,
+            .cgroup_fd = run->cgroup_fd,
+            .limits = run->limits,
+        };
+        start = _sf1_now_ns();
+        if (task->is_tee) {
+            builtin = (_sf1_builtin) { .fn = _sf1_tee, .ctx = NULL };
+            pid = _sf1_builtin_spawn(&builtin, &spawn);
+        } else if (_sf1_builtin_find(task->argv[0], &builtin)) {
+            pid = _sf1_builtin_spawn(&builtin, &spawn);
+        } else if (_sf1_forkserver_running()) {
+            pid = _sf1_forkserver_spawn(&spawn);
+        } else {
+            pid = _sf1_child_spawn(&spawn);
+        }
+        _SF1_PROBE(fork, task->argv[0], pid);
+        _sf1_phase_end(run->call_id, SYSTEMF1_TRACE_FORK, start, pid, (pid < 0) ? errno : 0);
+        if (pid < 0) {
+            _SF1_STAT(fork_failures);
+            fprintf(stderr, "systemf: %s forking %s\n", strerror(errno), task->argv[0]);
+            _sf1_close_child_files(files);
+            goto exit_error;
+        }
+        _sf1_close_child_files(files);
+        _SF1_STAT(tasks);
+        if (_sf1_debugging(SYSTEMF1_DBG_EXEC)) {
+            _sf1_debug_exec(task, pid);
         }
-        _sf1_close_child_files(&files);
 
-        pid_chain = _sf1_pid_chain_add(pid_chain, pid);
+        pid_chain = _sf1_pid_chain_add(run->pid_chain, pid);
         if (!pid_chain) {
-            fprintf(stderr, "systemf: pid_chain out of memory");
+            fprintf(stderr, "systemf: pid_chain out of memory\n");
+            _sf1_kill(pid, SIGKILL);
+            _sf1_waitpid(pid, NULL, 0);
             goto exit_error;
         }
+        run->pid_chain = pid_chain;
 
-        // Only wait for completion if this is not piped.  
+        // Only wait for completion if this is not piped.
         // I.E. "cat | grep" should run the grep before waiting for the cat to complete.
-        if (files.out_rd_pipe == 0) {
-            if (_sf1_pid_chain_waitpids(pid_chain, &stat, 0) == 0) {
-                // FIXME: Make sure this is the right return value and better recover from this.
-                fprintf(stderr, "waitpid unexpectedly returned %s", strerror(errno));
-                goto exit_error;
-            }
-            _sf1_pid_chain_clear(pid_chain);
+        if (files->out_rd_pipe == 0) {
+            run->wait_task = task;
+            run->next_task = task->next;
+            return 1;
+        }
+    }
+    run->next_task = NULL;
+    return 0;
 
-            retval = WEXITSTATUS(stat);
+exit_error:
+    // Nothing is left to read the pipe, and the group launched so far won't be waited for.
+    _sf1_close_child_files_and_pipe(files);
+    if (run->pid_chain) {
+        _sf1_pid_chain_kill(run->pid_chain);
+    }
+    run->next_task = NULL;
+    run->retval = -1;
+    return -1;
+}
 
-            if (WIFSIGNALED(stat)) {
-                fprintf(stderr, "waipid exited with signal %s\n", strsignal(WTERMSIG(stat)));
-                goto exit_error;
-            }
+/*
+ * Records the status of the last pid in run->pid_chain once every pid in it
+ * has been reaped and decides what is run next.
+ *
+ * Returns 0 on success and -1 if the run failed.
+ */
+int _sf1_run_reaped(_sf1_run *run, int stat) {
+    _sf1_task *task = run->wait_task;
 
-            DBG("waitpid returned with %3d %3d %3d %3d %3d\n", errno,
-                WIFEXITED(stat), WEXITSTATUS(stat), WIFSIGNALED(stat), WTERMSIG(stat));
+    pid_t last = run->pid_chain->pids[run->pid_chain->size - 1];
 
-            if (WIFSIGNALED(stat) || (WIFEXITED(stat) && WEXITSTATUS(stat))) {
-                if (task->next && (task->next->run_if == _SF1_RUN_IF_PREV_SUCCEEDED)) {
-                    DBG("exiting because previous failed");
-                    break;
-                }
-            } else {
-                if (task->next && (task->next->run_if == _SF1_RUN_IF_PREV_FAILED)) {
-                    DBG("exiting because previous succeeded");
-                    break;
-                }
+    _sf1_phase_end(run->call_id, SYSTEMF1_TRACE_EXEC, run->launched_ns, last, stat);
+    if (_sf1_debugging(SYSTEMF1_DBG_EXEC)) {
+        _sf1_debug_exit(last, stat, run->launched_ns);
+    }
+    _sf1_pid_chain_clear(run->pid_chain);
+    _sf1_admission_release(run->admitted);
+    run->admitted = 0;
+
+    run->retval = WEXITSTATUS(stat);
+
+    if (WIFSIGNALED(stat)) {
+        _SF1_STAT(signaled);
+        fprintf(stderr, "waipid exited with signal %s\n", strsignal(WTERMSIG(stat)));
+        run->next_task = NULL;
+        run->retval = -1;
+        return -1;
+    }
+
+    DBG("waitpid returned with %3d %3d %3d %3d %3d\n", errno,
+        WIFEXITED(stat), WEXITSTATUS(stat), WIFSIGNALED(stat), WTERMSIG(stat));
+
+    if (WIFSIGNALED(stat) || (WIFEXITED(stat) && WEXITSTATUS(stat))) {
+        if (task->next && (task->next->run_if == _SF1_RUN_IF_PREV_SUCCEEDED)) {
+            DBG("exiting because previous failed");
+            run->next_task = NULL;
+        }
+    } else {
+        if (task->next && (task->next->run_if == _SF1_RUN_IF_PREV_FAILED)) {
+            DBG("exiting because previous succeeded");
+            run->next_task = NULL;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Cleans up everything the run created locally, including the argv and globs
+ * of each task so the tasks can be run again.
+ */
+void _sf1_run_cleanup(_sf1_run *run) {
+    for (_sf1_task *task = run->tasks; task; task = task->next) {
+        _sf1_free(task->argv);
+        task->argv = NULL;
+        for (_sf1_task_arg *a = task->args; a; a = a->next) {
+            if (a->is_glob) {
+                globfree(&a->glob);
+                memset(&a->glob, 0, sizeof(a->glob));
             }
         }
     }
-    if (0) {
-        exit_error:
-        retval = -1;
+
+    _sf1_close_child_files(&run->files);
+    _sf1_pid_chain_free(run->pid_chain);
+    run->pid_chain = NULL;
+    if (run->admitted) {
+        _sf1_admission_release(run->admitted);
+        run->admitted = 0;
     }
+}
 
-    // Clean up everything locally created.
-    _sf1_close_child_files(&files);
-    _sf1_pid_chain_free(pid_chain);
-    
-    return retval;
+/*
+ * _sf1_run_init() for a run applying opts.  The working directory, cgroup, and
+ * environment it sets up are released by _sf1_run_finish().  Returns -1 if the
+ * run can't start, and then there is nothing to finish.
+ */
+int _sf1_run_start(_sf1_run *run, _sf1_task *tasks, const systemf1_opts *opts, unsigned long long call_id) {
+    if (_sf1_run_init(run, tasks)) {
+        return -1;
+    }
+    run->dirfd = _sf1_cwd_open(opts, &run->dirfd_owned);
+    if (run->dirfd == -1) {
+        _sf1_run_cleanup(run);
+        return -1;
+    }
+    if (_sf1_child_prepare(opts, &run->cgroup_fd)) {
+        _sf1_run_cleanup(run);
+        if (run->dirfd_owned) {
+            close(run->dirfd);
+        }
+        return -1;
+    }
+    run->limits = opts;
+    if (opts && opts->pipe_size) {
+        run->pipe_size = (opts->pipe_size > INT_MAX) ? INT_MAX : (int) opts->pipe_size;
+    }
+    run->envp = _sf1_env_acquire(opts, &run->env);
+    if (!run->envp) {
+        fprintf(stderr, "systemf: %s building the environment\n", strerror(errno));
+        run->next_task = NULL;
+        run->retval = -1;
+    }
+
+    run->call_id = call_id;
+    return 0;
+}
+
+/*
+ * Cleans up a run from _sf1_run_start() and returns its result.
+ */
+int _sf1_run_finish(_sf1_run *run) {
+    _sf1_run_cleanup(run);
+    _sf1_env_release(run->env);
+    if (run->dirfd_owned) {
+        close(run->dirfd);
+    }
+    if (run->cgroup_fd >= 0) {
+        close(run->cgroup_fd);
+    }
+
+    return run->retval;
 }
 
+int _sf1_tasks_run(_sf1_task *tasks, const systemf1_opts *opts, unsigned long long call_id) {
+    _sf1_run run;
+    int stat;
+
+    if (_sf1_run_start(&run, tasks, opts, call_id)) {
+        return -1;
+    }
+
+    while (_sf1_run_launch(&run) > 0) {
+        unsigned long long start = _sf1_now_ns();
+        pid_t last = run.pid_chain->pids[run.pid_chain->size - 1];
+
+        if (_sf1_pid_chain_waitpids(run.pid_chain, &stat, 0) == 0) {
+            // FIXME: Make sure this is the right return value and better recover from this.
+            fprintf(stderr, "waitpid unexpectedly returned %s", strerror(errno));
+            run.retval = -1;
+            break;
+        }
+        _sf1_phase_end(call_id, SYSTEMF1_TRACE_WAIT, start, last, stat);
+        if (_sf1_run_reaped(&run, stat)) {
+            break;
+        }
+    }
+
+    return _sf1_run_finish(&run);
+}
@@ -0,0 +1,129 @@
+#define _GNU_SOURCE // tee() and splice().
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "systemf-internal.h"
+
+#define TEE_BUFFER_SIZE 65536
+
+static int write_all(int fd, const char *buf, size_t size) {
+    while (size) {
+        ssize_t n = write(fd, buf, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += n;
+        size -= n;
+    }
+    return 0;
+}
+
+/*
+ * Copies in to out and file through a buffer until in ends.  Once nothing reads
+ * out, the rest only goes to file.  out is -1 when that is already the case.
+ */
+static int tee_copy(int in, int out, int file) {
+    char buf[TEE_BUFFER_SIZE];
+    ssize_t n;
+
+    while ((n = read(in, buf, sizeof(buf))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 1;
+        }
+        if ((out >= 0) && write_all(out, buf, n)) {
+            if (errno != EPIPE) {
+                return 1;
+            }
+            out = -1;
+        }
+        if (write_all(file, buf, n)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#ifdef __linux__
+/*
+ * Moves size bytes from the pipe in to file.  splice() can't write to every
+ * file, like ones opened to append on older kernels.  Then *copy is set and
+ * the bytes are copied from then on.
+ */
+static int tee_move(int in, int file, size_t size, int *copy) {
+    char buf[TEE_BUFFER_SIZE];
+
+    while (size) {
+        ssize_t n = 0;
+
+        if (!*copy) {
+            n = splice(in, NULL, file, NULL, size, SPLICE_F_MOVE);
+            if ((n < 0) && (errno == EINTR)) {
+                continue;
+            }
+            if ((n < 0) && (errno != EINVAL)) {
+                return -1;
+            }
+            *copy = (n < 0);
+        }
+        if (*copy) {
+            n = read(in, buf, (size < sizeof(buf)) ? size : sizeof(buf));
+            if ((n < 0) && (errno == EINTR)) {
+                continue;
+            }
+            if ((n <= 0) || write_all(file, buf, n)) {
+                return -1;
+            }
+        }
+        size -= n;
+    }
+    return 0;
+}
+#endif
+
+/*
+ * The tee task of "a |> file | b".  It reads a's output from stdin and writes it
+ * to b on stdout and to file, which is its stderr.  On Linux, tee() duplicates
+ * the data into b's pipe and splice() moves it to file, so it never passes
+ * through a buffer.  If b stops reading, file still gets all of it.
+ */
+int _sf1_tee(const systemf1_builtin_call *call) {
+    int in = call->in;
+    int out = call->out;
+    int file = call->err;
+
+#ifdef __linux__
+    int copy = 0;
+
+    for (;;) {
+        ssize_t n = tee(in, out, INT_MAX, 0);
+
+        if (n == 0) {
+            return 0;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EPIPE) {
+                out = -1;
+            } else if (errno != EINVAL) {
+                return 1;
+            }
+            // Either nothing reads out or they aren't both pipes.
+            break;
+        }
+        if (tee_move(in, file, n, &copy)) {
+            return 1;
+        }
+    }
+#endif
+    return tee_copy(in, out, file);
+}
@@ -0,0 +1,199 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "systemf-internal.h"
+
+#define TRACE_WORDS (sizeof(systemf1_trace_record) / sizeof(unsigned long long))
+_Static_assert(sizeof(systemf1_trace_record) % sizeof(unsigned long long) == 0,
+               "records are copied a word at a time");
+
+/*
+ * A slot is written by the one thread that moves seq from even to odd.  It holds
+ * record n of the ring once seq is 2n + 2.
+ */
+typedef struct {
+    unsigned long long seq;
+    unsigned long long words[TRACE_WORDS];
+} trace_slot;
+
+/*
+ * Rings are never freed since a thread that loaded one may still be writing to it.
+ */
+struct _sf1_trace_ring_ {
+    struct _sf1_trace_ring_ *prev;
+    unsigned long long mask;
+    unsigned long long head;    // The next record number to write.
+    unsigned long long tail;    // The next record number to drain.
+    unsigned long long dropped;
+    trace_slot slots[];
+};
+
+_sf1_trace_ring *_sf1_trace_active = NULL; // Written to.  NULL while tracing is off.
+static _sf1_trace_ring *trace_last = NULL;  // Read from, even after tracing is turned off.
+static unsigned long long trace_next_call = 0;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int systemf1_trace_set(size_t capacity) {
+    _sf1_trace_ring *ring;
+    size_t size = 1;
+
+    if (!capacity) {
+        __atomic_store_n(&_sf1_trace_active, NULL, __ATOMIC_RELEASE);
+        return 0;
+    }
+
+    while (size < capacity) {
+        size *= 2;
+    }
+    ring = _sf1_calloc(1, sizeof(*ring) + size * sizeof(trace_slot));
+    if (!ring) {
+        return -1;
+    }
+    ring->mask = size - 1;
+
+    pthread_mutex_lock(&trace_lock);
+    ring->prev = trace_last;
+    trace_last = ring;
+    __atomic_store_n(&_sf1_trace_active, ring, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&trace_lock);
+
+    return 0;
+}
+
+unsigned long long _sf1_trace_call(void) {
+    if (!_sf1_tracing()) {
+        return 0;
+    }
+    return __atomic_add_fetch(&trace_next_call, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * Adds a record for a phase of call_id.  A record is
+ * dropped rather than waited for when its slot is still being written by a
+ * thread a whole ring behind.
+ */
+void _sf1_trace_record(unsigned long long call_id, int phase, unsigned long long start_ns,
+                       unsigned long long duration_ns, pid_t pid, int status) {
+    _sf1_trace_ring *ring = __atomic_load_n(&_sf1_trace_active, __ATOMIC_ACQUIRE);
+    systemf1_trace_record record;
+    unsigned long long words[TRACE_WORDS];
+    unsigned long long n, seq;
+    trace_slot *slot;
+
+    if (!ring) {
+        return;
+    }
+    record = (systemf1_trace_record) {
+        .start_ns = start_ns,
+        .duration_ns = duration_ns,
+        .call_id = call_id,
+        .phase = phase,
+        .pid = pid,
+        .status = status,
+    };
+    memcpy(words, &record, sizeof(words));
+
+    n = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+    slot = &ring->slots[n & ring->mask];
+    seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    if ((seq & 1) || (seq > 2 * n) ||
+        !__atomic_compare_exchange_n(&slot->seq, &seq, 2 * n + 1, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (size_t i = 0; i < TRACE_WORDS; i++) {
+        __atomic_store_n(&slot->words[i], words[i], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&slot->seq, 2 * n + 2, __ATOMIC_RELEASE);
+}
+
+/*
+ * Copies record n into record.  Returns 1 if it was copied, -1 if it is being
+ * written, and 0 if it was overwritten or dropped.
+ */
+static int read_record(_sf1_trace_ring *ring, unsigned long long n, systemf1_trace_record *record) {
+    trace_slot *slot = &ring->slots[n & ring->mask];
+    unsigned long long words[TRACE_WORDS];
+    unsigned long long seq;
+
+    seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    if (seq != 2 * n + 2) {
+        return (seq == 2 * n + 1) ? -1 : 0;
+    }
+    for (size_t i = 0; i < TRACE_WORDS; i++) {
+        words[i] = __atomic_load_n(&slot->words[i], __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq) {
+        return 0;
+    }
+    memcpy(record, words, sizeof(words));
+    return 1;
+}
+
+/*
+ * The oldest record still in the ring that is n or after it.
+ */
+static unsigned long long oldest(_sf1_trace_ring *ring, unsigned long long head, unsigned long long n) {
+    return (head - n > ring->mask + 1) ? head - (ring->mask + 1) : n;
+}
+
+size_t systemf1_trace_snapshot(systemf1_trace_record *records, size_t count) {
+    unsigned long long n, head;
+    size_t copied = 0;
+
+    pthread_mutex_lock(&trace_lock);
+    if (trace_last) {
+        head = __atomic_load_n(&trace_last->head, __ATOMIC_ACQUIRE);
+        n = oldest(trace_last, head, trace_last->tail);
+        if (head - n > count) {
+            n = head - count;
+        }
+        for (; n < head; n++) {
+            copied += read_record(trace_last, n, &records[copied]) > 0;
+        }
+    }
+    pthread_mutex_unlock(&trace_lock);
+
+    return copied;
+}
+
+size_t systemf1_trace_drain(systemf1_trace_record *records, size_t count) {
+    _sf1_trace_ring *ring;
+    unsigned long long n, head;
+    size_t copied = 0;
+
+    pthread_mutex_lock(&trace_lock);
+    ring = trace_last;
+    if (ring) {
+        head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        n = oldest(ring, head, ring->tail);
+        __atomic_add_fetch(&ring->dropped, n - ring->tail, __ATOMIC_RELAXED);
+        // A record still being written is left for the next drain.
+        for (; (n < head) && (copied < count); n++) {
+            int ret = read_record(ring, n, &records[copied]);
+            if (ret < 0) {
+                break;
+            }
+            copied += ret;
+        }
+        ring->tail = n;
+    }
+    pthread_mutex_unlock(&trace_lock);
+
+    return copied;
+}
+
+unsigned long long systemf1_trace_dropped(void) {
+    unsigned long long dropped = 0;
+
+    pthread_mutex_lock(&trace_lock);
+    for (_sf1_trace_ring *ring = trace_last; ring; ring = ring->prev) {
+        dropped += __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&trace_lock);
+
+    return dropped;
+}
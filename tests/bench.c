@@ -0,0 +1,306 @@
+/*
+ * bench - Benchmarks of systemf printed as JSON for diffing between releases.
+ * Run with 'make bench' or from the tests directory as ../benchmark [filter].
+ * Only benchmarks with filter in their name are run.  BENCH_PIPELINE_BYTES sets
+ * how much the pipeline benchmarks move per call, 16 MiB by default.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "systemf-internal.h"
+
+extern char **environ;
+
+#define PIPELINE_BYTES (16 * 1024 * 1024)
+#define BIG_BYTES (512UL * 1024 * 1024)
+
+static size_t pipeline_bytes = PIPELINE_BYTES;
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+    int is_micro;          // Timed in batches instead of one call at a time.
+    const size_t *bytes;   // Bytes moved per call, for a throughput.
+    void (*setup)(void);   // Run before the benchmark when set.
+    void (*teardown)(void); // Run after it when set.
+} benchmark;
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void must(int ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "bench: %s failed: %s\n", what, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void parse(const char *fmt, const systemf1_arg *args, size_t nargs) {
+    _sf1_parse_args parse_args = { .args = args, .nargs = nargs };
+    _sf1_task *tasks = _sf1_parse(fmt, &parse_args);
+
+    must(tasks != NULL, fmt);
+    _sf1_task_free(tasks);
+}
+
+static void bench_parse_short(void) {
+    static const systemf1_arg args[] = { {.s = "one"} };
+    parse("./cmd comma %s", args, 1);
+}
+
+static void bench_parse_long(void) {
+    static const systemf1_arg args[] = {
+        {.s = "one"}, {.s = "two"}, {.s = "three"}, {.s = "four"}, {.s = "in"}, {.s = "out"}, {.s = "run-?"},
+    };
+    parse("./cmd comma a b c d e f g h %s %s x%sy z%s | ./cmd cat <%p 2>&1 | "
+          "./cmd cat >tmp/bench/%p && ./cmd true || ./cmd false ; ./cmd comma *.[ch] job/%*p.log",
+          args, 7);
+}
+
+static _sf1_syllable *syllable(const char *text, int flags, _sf1_syllable *next) {
+    size_t len = strlen(text);
+    _sf1_syllable *s = _sf1_malloc(sizeof(*s) + len + 1);
+
+    must(s != NULL, "malloc");
+    memcpy(s->buf, text, len + 1);
+    s->text = s->buf;
+    s->flags = flags;
+    s->next = next;
+    s->next_word = NULL;
+    return s;
+}
+
+static void bench_merge_syllables(void) {
+    _sf1_syllable *syl = NULL;
+    char *text, *trusted_path;
+    int is_glob;
+
+    syl = syllable(".log", SYL_IS_TRUSTED, syl);
+    syl = syllable("name*?", SYL_IS_FILE | SYL_ESCAPE_GLOB, syl);
+    syl = syllable("/", SYL_IS_TRUSTED, syl);
+    syl = syllable("job", SYL_IS_FILE | SYL_ESCAPE_GLOB, syl);
+    syl = syllable("/var/lib/jobs/", SYL_IS_TRUSTED, syl);
+    _sf1_merge_and_free_syllables(syl, &text, &trusted_path, &is_glob);
+    _sf1_free(text);
+    _sf1_free(trusted_path);
+}
+
+static void bench_sandbox_simple(void) {
+    must(_sf1_file_sandbox_check("", "job/a/b/c.log") == 0, "sandbox");
+}
+
+static void bench_sandbox_complex(void) {
+    must(_sf1_file_sandbox_check("job/", "job/a/../b/./c/../../d.log") == 0, "sandbox");
+}
+
+static void bench_glob(void) {
+    glob_t g = {0};
+
+    must(_sf1_glob_at(AT_FDCWD, "*", &g) == 0, "glob");
+    globfree(&g);
+}
+
+static void bench_spawn_systemf1(void) {
+    must(systemf1("./cmd true") == 0, "systemf1");
+}
+
+static void bench_spawn_system(void) {
+    must(system("./cmd true") == 0, "system");
+}
+
+static void bench_spawn_posix_spawn(void) {
+    char *argv[] = { "./cmd", "true", NULL };
+    pid_t pid;
+    int stat;
+
+    must(posix_spawn(&pid, argv[0], NULL, NULL, argv, environ) == 0, "posix_spawn");
+    must(waitpid(pid, &stat, 0) == pid, "waitpid");
+}
+
+static void bench_spawn_fork_exec(void) {
+    char *argv[] = { "./cmd", "true", NULL };
+    pid_t pid = fork();
+    int stat;
+
+    must(pid >= 0, "fork");
+    if (pid == 0) {
+        execv(argv[0], argv);
+        _exit(127);
+    }
+    must(waitpid(pid, &stat, 0) == pid, "waitpid");
+}
+
+/*
+ * Makes this a parent with BIG_BYTES of memory in use, which every fork() has
+ * to copy the page tables of.
+ */
+static void grow(void) {
+    static char *big;
+
+    if (!big) {
+        big = malloc(BIG_BYTES);
+        must(big != NULL, "malloc");
+        memset(big, 1, BIG_BYTES);
+    }
+}
+
+static void forkserver_start(void) {
+    must(systemf1_forkserver_start() == 0, "systemf1_forkserver_start");
+    grow();
+}
+
+static void bench_spawn_big(void) {
+    must(systemf1("./cmd true") == 0, "systemf1");
+}
+
+static void bench_pipeline_cat(void) {
+    must(systemf1("./cmd bigcat <tmp/bench/in | ./cmd bigcat | ./cmd bigcat >/dev/null") == 0, "pipeline");
+}
+
+static void bench_pipeline_cat_big_pipes(void) {
+    static const systemf1_opts opts = { .pipe_size = 1024 * 1024 };
+    must(systemf1_ex(&opts, "./cmd bigcat <tmp/bench/in | ./cmd bigcat | ./cmd bigcat >/dev/null") == 0,
+         "pipeline");
+}
+
+static void bench_chain_and(void) {
+    must(systemf1("./cmd true && ./cmd true && ./cmd true && ./cmd true") == 0, "chain");
+}
+
+static void bench_chain_system(void) {
+    must(system("./cmd true && ./cmd true && ./cmd true && ./cmd true") == 0, "system chain");
+}
+
+static const benchmark benchmarks[] = {
+    { "parse/short", bench_parse_short, 1 },
+    { "parse/long", bench_parse_long, 1 },
+    { "merge_syllables", bench_merge_syllables, 1 },
+    { "sandbox/simple", bench_sandbox_simple, 1 },
+    { "sandbox/complex", bench_sandbox_complex, 1 },
+    { "glob", bench_glob, 1 },
+    { "spawn/systemf1", bench_spawn_systemf1, 0 },
+    { "spawn/system", bench_spawn_system, 0 },
+    { "spawn/posix_spawn", bench_spawn_posix_spawn, 0 },
+    { "spawn/fork_exec", bench_spawn_fork_exec, 0 },
+    // The forkserver was started while small, so it's the one to run first.
+    { "spawn/big_forkserver", bench_spawn_big, 0, 0, forkserver_start, systemf1_forkserver_stop },
+    { "spawn/big_fork", bench_spawn_big, 0, 0, grow },
+    { "pipeline/cat", bench_pipeline_cat, 0, &pipeline_bytes },
+    { "pipeline/cat_1mib_pipes", bench_pipeline_cat_big_pipes, 0, &pipeline_bytes },
+    { "chain/and4", bench_chain_and, 0 },
+    { "chain/and4_system", bench_chain_system, 0 },
+};
+
+static int compare_ull(const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long *) a;
+    unsigned long long y = *(const unsigned long long *) b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Micro benchmarks are timed in batches of calls so the clock isn't what is
+ * measured.  Each sample is the mean of a batch.
+ */
+static void run(const benchmark *b, const char *delim) {
+    enum { SAMPLES = 31 };
+    unsigned long long samples[SAMPLES];
+    unsigned long long total = 0;
+    size_t batch = 1;
+
+    if (b->setup) {
+        b->setup();
+    }
+    b->run(); // Warm up.
+    if (b->is_micro) {
+        // Grow the batch until it takes about a millisecond.
+        for (;;) {
+            unsigned long long start = now_ns();
+            for (size_t i = 0; i < batch; i++) {
+                b->run();
+            }
+            if ((now_ns() - start > 1000000) || (batch >= (1 << 24))) {
+                break;
+            }
+            batch *= 2;
+        }
+    }
+
+    for (int s = 0; s < SAMPLES; s++) {
+        unsigned long long start = now_ns();
+        for (size_t i = 0; i < batch; i++) {
+            b->run();
+        }
+        samples[s] = (now_ns() - start) / batch;
+        total += samples[s];
+    }
+    qsort(samples, SAMPLES, sizeof(samples[0]), compare_ull);
+
+    printf("%s\n    {\"name\": \"%s\", \"iterations\": %zu, \"mean_ns\": %llu, "
+           "\"min_ns\": %llu, \"median_ns\": %llu, \"max_ns\": %llu",
+           delim, b->name, batch * SAMPLES, total / SAMPLES,
+           samples[0], samples[SAMPLES / 2], samples[SAMPLES - 1]);
+    if (b->bytes) {
+        printf(", \"bytes_per_sec\": %.0f", *b->bytes * 1e9 / samples[SAMPLES / 2]);
+    }
+    printf("}");
+    fflush(stdout);
+    if (b->teardown) {
+        b->teardown();
+    }
+}
+
+static void setup(void) {
+    char block[65536];
+    int fd;
+
+    memset(block, 'x', sizeof(block));
+    must((mkdir("tmp", 0777) == 0) || (errno == EEXIST), "mkdir tmp");
+    must((mkdir("tmp/bench", 0777) == 0) || (errno == EEXIST), "mkdir tmp/bench");
+    fd = open("tmp/bench/in", O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    must(fd >= 0, "open tmp/bench/in");
+    for (size_t written = 0; written < pipeline_bytes; written += sizeof(block)) {
+        size_t size = (pipeline_bytes - written < sizeof(block)) ? pipeline_bytes - written : sizeof(block);
+        must(write(fd, block, size) == (ssize_t) size, "write tmp/bench/in");
+    }
+    close(fd);
+}
+
+int main(int argc, char *argv[]) {
+    const char *filter = (argc > 1) ? argv[1] : "";
+    const char *delim = "";
+
+    if (access("./cmd", X_OK)) {
+        fputs("bench: run from the tests directory where ./cmd is.\n", stderr);
+        return EXIT_FAILURE;
+    }
+    if (getenv("BENCH_PIPELINE_BYTES")) {
+        pipeline_bytes = strtoull(getenv("BENCH_PIPELINE_BYTES"), NULL, 0);
+        must(pipeline_bytes > 0, "BENCH_PIPELINE_BYTES");
+    }
+    setup();
+
+    printf("{\n  \"benchmarks\": [");
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+        if (strstr(benchmarks[i].name, filter)) {
+            run(&benchmarks[i], delim);
+            delim = ",";
+        }
+    }
+    printf("\n  ]\n}\n");
+
+    unlink("tmp/bench/in");
+    return 0;
+}
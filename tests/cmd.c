@@ -3,10 +3,39 @@
  * test command with no reliance on any external files.
  */
 
+#define _GNU_SOURCE // F_GETPIPE_SZ.
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+
+/*
+ * cat in 1 MiB blocks, so the pipes are what limits the throughput.
+ */
+static int bigcat(void) {
+    enum { SIZE = 1024 * 1024 };
+    char *buf = malloc(SIZE);
+    ssize_t count;
+
+    if (!buf) {
+        return 1;
+    }
+    while ((count = read(0, buf, SIZE)) > 0) {
+        for (ssize_t done = 0; done < count; ) {
+            ssize_t n = write(1, buf + done, count - done);
+            if (n < 0) {
+                free(buf);
+                return 1;
+            }
+            done += n;
+        }
+    }
+    free(buf);
+    return count < 0;
+}
 
 static void cat(void) {
     char buf[257];
@@ -34,7 +63,14 @@ int main(int argc, char *argv[]) {
             "true:   set the return value to 0 (the default).\n"
             "false:  set the return value to 1.\n"
             "count:  countinuously count from 1 to infinity to stdout with a newline.\n"
-            "return: set the return value to the next argument\n");
+            "return: set the return value to the next argument\n"
+            "env:    print the environment variable named by the next argument, or - if it isn't set.\n"
+            "nofile: print the soft limit on open files.\n"
+            "nice:   print the nice value.\n"
+            "sleep:  sleep for the next argument in milliseconds.\n"
+            "ppid:   print the parent's pid.\n"
+            "bigcat: copy the stdin to the stdout in 1 MiB blocks.\n"
+            "pipesize: print the capacity of the pipe on stdin.\n");
         return retval;
     } 
 
@@ -45,6 +81,8 @@ int main(int argc, char *argv[]) {
             fprintf(stderr, "2");
         } else if (!strcmp("cat", argv[argi])) {
             cat();
+        } else if (!strcmp("bigcat", argv[argi])) {
+            retval = bigcat();
         } else if (!strcmp("{}", argv[argi])) {
             printf("{");
             cat();
@@ -69,6 +107,34 @@ int main(int argc, char *argv[]) {
             for (int i=1; 1; i += 1) {
                 printf("%d\n", i);
             }
+        } else if (!strcmp("env", argv[argi]))  {
+            argi++;
+            if (argi < argc) {
+                char *value = getenv(argv[argi]);
+                printf("%s", value ? value : "-");
+            }
+        } else if (!strcmp("nofile", argv[argi]))  {
+            struct rlimit rlim;
+            if (!getrlimit(RLIMIT_NOFILE, &rlim)) {
+                printf("%llu", (unsigned long long) rlim.rlim_cur);
+            }
+        } else if (!strcmp("nice", argv[argi]))  {
+            printf("%d", getpriority(PRIO_PROCESS, 0));
+        } else if (!strcmp("sleep", argv[argi]))  {
+            argi++;
+            if (argi < argc) {
+                int ms = atoi(argv[argi]);
+                struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L };
+                nanosleep(&ts, NULL);
+            }
+        } else if (!strcmp("ppid", argv[argi]))  {
+            printf("%d", (int) getppid());
+        } else if (!strcmp("pipesize", argv[argi]))  {
+#ifdef F_GETPIPE_SZ
+            printf("%d", fcntl(0, F_GETPIPE_SZ));
+#else
+            printf("-1");
+#endif
         } else if (!strcmp("return", argv[argi]))  {
             argi++;
             if (argi < argc) {
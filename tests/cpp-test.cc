@@ -0,0 +1,237 @@
+/*
+ * cpp-test - Tests of systemf.hpp.  Built as cpp17 and cpp20 so both ways of
+ * passing the format are covered.  Formats it should reject are checked with
+ * static_assert().  Run from the tests directory.  Output is TAP.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "systemf.hpp"
+
+#if defined(__cpp_consteval) && defined(__cpp_lib_type_identity)
+#define FMT(fmt) fmt
+#if defined(__cpp_impl_coroutine)
+#define HAVE_COROUTINES 1
+#endif
+#else
+#define FMT(fmt) SYSTEMF1_FMT(fmt)
+#endif
+
+using systemf::accepts;
+
+static_assert(accepts<>("./cmd stdout >tmp/out 2>&1 && ./cmd true || ./cmd false ; ./cmd stdout | ./cmd cat"));
+static_assert(accepts<>("./cmd comma *.[ch] ?"));
+static_assert(accepts<std::string>("./cmd stdout |> out | ./cmd cat |>>%p | ./cmd cat"));
+static_assert(accepts<const char *, std::string, std::string_view>("./cmd comma %s %p x%*py"));
+static_assert(accepts<int, short, unsigned short>("./cmd comma %d %d <%F"));
+static_assert(accepts<std::vector<const char *>, std::array<const char *, 2>>("./cmd comma %@s %@p"));
+static_assert(accepts<std::vector<std::string>, std::list<std::string_view>>("./cmd comma %@s %@p"));
+
+static_assert(!accepts<>("./cmd comma $HOME"));
+static_assert(!accepts<>("./cmd comma a\nb"));
+static_assert(!accepts<>("./cmd comma [] ["));
+static_assert(!accepts<int>("./cmd comma %x"));
+static_assert(!accepts<>("./cmd comma %s"));
+static_assert(!accepts<const char *, const char *>("./cmd comma %s"));
+static_assert(!accepts<int>("./cmd comma %s"));
+static_assert(!accepts<std::nullptr_t>("./cmd comma %s"));
+static_assert(!accepts<const char *>("./cmd comma %d"));
+static_assert(!accepts<long long>("./cmd comma %d"));
+static_assert(!accepts<unsigned>("./cmd comma %d"));
+static_assert(!accepts<bool>("./cmd comma %d"));
+static_assert(!accepts<char>("./cmd comma %d"));
+static_assert(!accepts<std::string>("./cmd comma %@s"));
+static_assert(!accepts<std::vector<int>>("./cmd comma %@s"));
+
+static_assert(!std::is_copy_constructible_v<systemf::process>);
+static_assert(!std::is_copy_assignable_v<systemf::process>);
+static_assert(std::is_nothrow_move_constructible_v<systemf::process>);
+static_assert(std::is_nothrow_move_assignable_v<systemf::process>);
+
+static int test = 0;
+
+static std::string slurp(const char *path) {
+    std::ifstream in(path);
+    std::stringstream text;
+
+    text << in.rdbuf();
+    return text.str();
+}
+
+static void check(bool ok, const char *name, const std::string &got = "") {
+    std::printf("%s %d - %s\n", ok ? "ok" : "not ok", ++test, name);
+    if (!ok && !got.empty()) {
+        std::printf("# got '%s'\n", got.c_str());
+    }
+}
+
+static void check_out(int ret, const char *expected, const char *name) {
+    std::string out = slurp("tmp-cpp/out");
+
+    check(!ret && (out == expected), name, out);
+}
+
+static bool no_children() {
+    return (waitpid(-1, nullptr, WNOHANG) == -1) && (errno == ECHILD);
+}
+
+static void test_process() {
+    std::string temporary = "six";
+    systemf::process proc = systemf::start(FMT("./cmd comma %s %@s >tmp-cpp/out"), std::string("five"),
+                                           std::vector<std::string_view>{temporary, "seven"});
+    temporary = "changed";
+    check_out(proc.wait(), "five,six,seven", "start() copies its arguments");
+
+    proc = systemf::process();
+    check(!proc && (proc.poll() == -1) && (proc.wait() == -1) && !proc.kill(), "a process that didn't start failed");
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        systemf::process sleeping = systemf::start(FMT("./cmd sleep 60000 | ./cmd cat ; ./cmd stdout"));
+        systemf::process moved = std::move(sleeping);
+        check(!moved.poll() && !sleeping && (sleeping.poll() == -1), "moving leaves the run with the new process");
+    }
+    check(no_children() && (std::chrono::steady_clock::now() - start < std::chrono::seconds(30)),
+          "destroying a running process kills and reaps it");
+
+    proc = systemf::start(FMT("./cmd sleep 60000"));
+    check(proc.kill() && (proc.wait() == -1) && !proc.kill(), "kill()");
+}
+
+#ifdef HAVE_COROUTINES
+/*
+ * The smallest event loop systemf::awaitable needs.
+ */
+struct loop {
+    std::multimap<int, std::function<void()>> watches;
+
+    void watch(int fd, std::function<void()> callback) {
+        watches.emplace(fd, std::move(callback));
+    }
+
+    void run() {
+        while (!watches.empty()) {
+            std::vector<pollfd> fds;
+            for (auto &w : watches) {
+                fds.push_back({w.first, POLLIN, 0});
+            }
+            if (::poll(fds.data(), fds.size(), 10000) <= 0) {
+                return;
+            }
+            for (pollfd &p : fds) {
+                auto w = watches.find(p.fd);
+                if ((p.revents & POLLIN) && (w != watches.end())) {
+                    std::function<void()> callback = std::move(w->second);
+                    watches.erase(w);
+                    callback();
+                }
+            }
+        }
+    }
+};
+
+/*
+ * A coroutine that starts right away and frees itself when it returns.
+ */
+struct task {
+    struct promise_type {
+        task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+static task run_one(loop &events, const char *word, int *result, int *in_flight, int *most) {
+    *most = std::max(*most, ++*in_flight);
+    *result = co_await systemf::run_async(events, "./cmd sleep 50 && ./cmd comma %s >tmp-cpp/%p", word, word);
+    --*in_flight;
+}
+
+static task wait_on(loop &events, systemf::process &proc, int *result) {
+    *result = co_await proc.wait_on(events);
+}
+
+static void test_coroutines() {
+    loop events;
+    int results[2] = {-2, -2};
+    int in_flight = 0, most = 0;
+
+    run_one(events, "first", &results[0], &in_flight, &most);
+    run_one(events, "second", &results[1], &in_flight, &most);
+    events.run();
+    check(!results[0] && !results[1] && (most == 2) && !in_flight && (slurp("tmp-cpp/first") == "first") &&
+          (slurp("tmp-cpp/second") == "second"), "co_await run_async() runs calls side by side");
+
+    int result = -2;
+    systemf::process proc = systemf::start("./cmd stdout | ./cmd cat >tmp-cpp/out");
+    wait_on(events, proc, &result);
+    events.run();
+    check_out(result, "1", "co_await wait_on()");
+}
+#endif
+
+int main() {
+    // Not under tmp, which tests/test.test deletes while 'make -j check' runs this.
+    if (mkdir("tmp-cpp", 0777) && (errno != EEXIST)) {
+        std::perror("cpp-test: mkdir tmp-cpp");
+        return 1;
+    }
+
+    const char *c = "one";
+    std::string s = "two";
+    std::string_view view = std::string_view("three four").substr(0, 5);
+    check_out(systemf::run(FMT("./cmd comma %s %s %s >tmp-cpp/out"), c, s, view), "one,two,three",
+              "strings of every kind");
+
+    short small = -3;
+    unsigned char byte = 200;
+    check_out(systemf::run(FMT("./cmd comma %d x%dy >tmp-cpp/out"), small, byte), "-3,x200y", "integers");
+
+    std::vector<const char *> pointers = {"a", "b"};
+    std::vector<std::string> strings = {"c", "d"};
+    std::list<std::string_view> views = {"e", "f"};
+    check_out(systemf::run(FMT("./cmd comma %@s %@s %@s >tmp-cpp/out"), pointers, strings, views), "a,b,c,d,e,f",
+              "ranges of strings");
+
+    std::vector<std::string> none;
+    check_out(systemf::run(FMT("./cmd comma x %@s y >tmp-cpp/out"), none), "x,y", "empty range");
+
+    check(systemf::run(FMT("./cmd comma %p >tmp-cpp/out"), std::string("../escape")) == -1,
+          "sandbox still applies");
+
+    std::vector<std::string> files = {"in", "../escape"};
+    check(systemf::run(FMT("./cmd comma %@p >tmp-cpp/out"), files) == -1, "sandbox applies to each of %@p");
+
+    systemf1_opts opts = {};
+    opts.cwd = "tmp-cpp";
+    check_out(systemf::run_ex(opts, FMT("../../cmd comma %s >out"), std::string("there")), "there", "run_ex()");
+
+    check(systemf::run(FMT("./cmd false")) != 0, "failures are returned");
+
+    test_process();
+#ifdef HAVE_COROUTINES
+    test_coroutines();
+#endif
+    std::printf("1..%d\n", test);
+    return 0;
+}
@@ -0,0 +1,312 @@
+/*
+ * stress - Runs failing and succeeding calls over and over and checks that
+ * nothing is left behind: every allocation is freed, no fds are left open, no
+ * children are left running or unreaped, and the RSS stays flat.
+ *
+ * Run from the tests directory as ../stress [rounds].  Each round runs the cases
+ * that launch children once and the ones that don't STRESS_CHEAP times.  Output
+ * is TAP.  -v leaves systemf's messages on stderr.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "systemf.h"
+
+#define STRESS_CHEAP 100
+#define STRESS_RSS_SLACK_KB 1024
+
+typedef struct {
+    const char *name;
+    int (*run)(void);
+    int expected;          // The return expected from run.
+    int launches;          // Launches children, so it is run less often.
+} stress_case;
+
+static long live_allocs = 0;
+
+static void *count_malloc(size_t size, void *ctx) {
+    void *ptr = malloc(size);
+    live_allocs += ptr != NULL;
+    return ptr;
+}
+
+static void *count_realloc(void *ptr, size_t size, void *ctx) {
+    return realloc(ptr, size);
+}
+
+static void count_free(void *ptr, void *ctx) {
+    live_allocs--;
+    free(ptr);
+}
+
+static int syntax_error(void) {
+    return systemf1("./cmd comma a >tmp-stress/out &&");
+}
+
+static int syntax_error_in_redirects(void) {
+    return systemf1("./cmd comma a 2>&1 <tmp-stress/in >");
+}
+
+static int syntax_error_after_a_pipe(void) {
+    return systemf1("./cmd stdout | ./cmd cat %s ; ;", "x");
+}
+
+static int too_few_arguments(void) {
+    systemf1_arg args[] = { {.s = "one"} };
+    int result;
+
+    systemf1_batch(NULL, "./cmd comma %s %s", args, 1, 1, 1, &result);
+    return result;
+}
+
+static int sandbox_denied(void) {
+    return systemf1("./cmd comma %p", "../escape");
+}
+
+static int glob_no_match(void) {
+    return systemf1("./cmd comma %*p", "tmp-stress/none-*");
+}
+
+static int missing_input(void) {
+    return systemf1("./cmd cat <tmp-stress/none");
+}
+
+static int fd_not_open(void) {
+    return systemf1("./cmd stdout 2>/dev/null >%F", 999);
+}
+
+static int missing_cwd(void) {
+    systemf1_opts opts = { .cwd = "tmp-stress/none" };
+
+    return systemf1_ex(&opts, "./cmd stdout");
+}
+
+static int pipeline(void) {
+    return systemf1("./cmd stdout | ./cmd cat | ./cmd cat >/dev/null");
+}
+
+static int chain(void) {
+    return systemf1("./cmd false || ./cmd true && ./cmd true ; ./cmd stdout >/dev/null 2>&1");
+}
+
+static int exec_failure(void) {
+    return systemf1("./does-not-exist") ? -1 : 0;
+}
+
+static int pipe_to_missing_output(void) {
+    return systemf1("./cmd stdout | ./cmd cat >tmp-stress/none/out");
+}
+
+static int pipe_to_denied_argument(void) {
+    return systemf1("./cmd stdout | ./cmd cat | ./cmd comma %p >/dev/null", "../escape");
+}
+
+static int pipe_from_missing_input(void) {
+    return systemf1("./cmd stdout | ./cmd cat <tmp-stress/none | ./cmd cat");
+}
+
+static int batch(void) {
+    systemf1_arg args[] = { {.s = "a"}, {.s = "../escape"}, {.s = "b"}, {.s = "../../escape"} };
+    int results[4];
+
+    if (systemf1_batch(NULL, "./cmd stdout | ./cmd comma %p >/dev/null", args, 1, 4, 2, results)) {
+        return -2;
+    }
+    return results[0] || (results[1] != -1) || results[2] || (results[3] != -1);
+}
+
+static int started_and_freed(void) {
+    systemf1_proc *proc = systemf1_start(NULL, "./cmd stdout | ./cmd cat | ./cmd cat >/dev/null ; ./cmd true");
+
+    systemf1_proc_free(proc);
+    return proc ? 0 : -1;
+}
+
+static int started_and_polled(void) {
+    systemf1_proc *proc = systemf1_start(NULL, "./cmd stdout | ./cmd comma %p >/dev/null && ./cmd true", "../escape");
+    int result = 0;
+
+    while (proc && systemf1_proc_poll(proc, &result));
+    systemf1_proc_free(proc);
+    return result;
+}
+
+/*
+ * A builtin that copies its stdin to its stdout.
+ */
+static int copy(const systemf1_builtin_call *call) {
+    char buf[4096];
+    ssize_t n;
+
+    while ((n = read(call->in, buf, sizeof(buf))) > 0) {
+        if (write(call->out, buf, n) != n) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int builtin_pipeline(void) {
+    return systemf1("./cmd stdout | copy | ./cmd cat | copy >/dev/null");
+}
+
+static int tee(void) {
+    return systemf1("./cmd stdout |> tmp-stress/tee | ./cmd cat |> tmp-stress/none/tee | ./cmd cat >/dev/null");
+}
+
+static int builtin_started_and_freed(void) {
+    systemf1_proc *proc = systemf1_start(NULL, "./cmd count | copy | ./cmd cat >/dev/null");
+
+    systemf1_proc_free(proc);
+    return proc ? 0 : -1;
+}
+
+static const stress_case cases[] = {
+    { "syntax error", syntax_error, -1, 0 },
+    { "syntax error in redirects", syntax_error_in_redirects, -1, 0 },
+    { "syntax error after a pipe", syntax_error_after_a_pipe, -1, 0 },
+    { "too few arguments", too_few_arguments, -1, 0 },
+    { "sandbox denied", sandbox_denied, -1, 0 },
+    { "glob with no match", glob_no_match, -1, 0 },
+    { "missing input", missing_input, -1, 0 },
+    { "fd that isn't open", fd_not_open, -1, 0 },
+    { "missing cwd", missing_cwd, -1, 0 },
+    { "pipeline", pipeline, 0, 1 },
+    { "chain", chain, 0, 1 },
+    { "exec failure", exec_failure, -1, 1 },
+    { "pipe to a missing output", pipe_to_missing_output, -1, 1 },
+    { "pipe to a denied argument", pipe_to_denied_argument, -1, 1 },
+    { "pipe from a missing input", pipe_from_missing_input, -1, 1 },
+    { "batch", batch, 0, 1 },
+    { "started and freed", started_and_freed, 0, 1 },
+    { "started and polled", started_and_polled, -1, 1 },
+    { "builtin pipeline", builtin_pipeline, 0, 1 },
+    { "builtin started and freed", builtin_started_and_freed, 0, 1 },
+    { "tee to a missing output", tee, -1, 1 },
+};
+#define CASE_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+static int open_fds(void) {
+    int count = 0;
+
+    for (int fd = 0; fd < 1024; fd++) {
+        count += fcntl(fd, F_GETFD) >= 0;
+    }
+    return count;
+}
+
+static long rss_kb(void) {
+    FILE *statm = fopen("/proc/self/statm", "r");
+    long size, resident = 0;
+
+    if (statm) {
+        if (fscanf(statm, "%ld %ld", &size, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(statm);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/*
+ * Returns 1 if this process has no children, running or not.
+ */
+static int no_children(void) {
+    return (waitpid(-1, NULL, WNOHANG) < 0) && (errno == ECHILD);
+}
+
+int main(int argc, char *argv[]) {
+    long rounds = 200;
+    int verbose = 0;
+    int fds, null_fd;
+    long rss_start = 0, rss_end;
+    long leaks[CASE_COUNT] = { 0 };
+    int wrong[CASE_COUNT] = { 0 };
+    int orphans[CASE_COUNT] = { 0 };
+    int test = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-v")) {
+            verbose = 1;
+        } else {
+            rounds = strtol(argv[i], NULL, 10);
+        }
+    }
+    if (access("./cmd", X_OK)) {
+        fputs("stress: run from the tests directory where ./cmd is.\n", stderr);
+        return EXIT_FAILURE;
+    }
+    // Not under tmp, which tests/test.test deletes while 'make -j check' runs this.
+    if ((mkdir("tmp-stress", 0777) != 0) && (errno != EEXIST)) {
+        perror("stress: mkdir tmp-stress");
+        return EXIT_FAILURE;
+    }
+
+    // Every failing call prints why.
+    if (!verbose) {
+        null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, 2);
+        close(null_fd);
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    systemf1_register_builtin("copy", copy, NULL);
+    systemf1_set_allocator(count_malloc, count_realloc, count_free, NULL);
+    fds = open_fds();
+
+    printf("1..%zu\n", CASE_COUNT + 3);
+    printf("# %ld rounds\n", rounds);
+    for (long r = 0; r < rounds; r++) {
+        if (r == rounds / 10) {
+            // After the allocator and page cache have warmed up.
+            rss_start = rss_kb();
+        }
+        for (size_t c = 0; c < CASE_COUNT; c++) {
+            for (int i = 0; i < (cases[c].launches ? 1 : STRESS_CHEAP); i++) {
+                long before = live_allocs;
+                int ret = cases[c].run();
+
+                if (live_allocs != before) {
+                    leaks[c] += live_allocs - before;
+                }
+                if (ret != cases[c].expected) {
+                    wrong[c]++;
+                }
+                if (cases[c].launches && !no_children()) {
+                    orphans[c]++;
+                    while (waitpid(-1, NULL, 0) > 0);
+                }
+            }
+        }
+    }
+    rss_end = rss_kb();
+
+    for (size_t c = 0; c < CASE_COUNT; c++) {
+        int ok = !leaks[c] && !wrong[c] && !orphans[c];
+
+        printf("%s %d - %s\n", ok ? "ok" : "not ok", ++test, cases[c].name);
+        if (leaks[c]) {
+            printf("# %ld allocations leaked\n", leaks[c]);
+        }
+        if (wrong[c]) {
+            printf("# %d calls didn't return %d\n", wrong[c], cases[c].expected);
+        }
+        if (orphans[c]) {
+            printf("# %d calls left children behind\n", orphans[c]);
+        }
+    }
+    printf("%s %d - fds stay flat (%d before, %d after)\n",
+           (open_fds() == fds) ? "ok" : "not ok", ++test, fds, open_fds());
+    printf("%s %d - no children left\n", no_children() ? "ok" : "not ok", ++test);
+    printf("%s %d - RSS stays flat (%ld KiB after warming up, %ld KiB at the end)\n",
+           (rss_end - rss_start <= STRESS_RSS_SLACK_KB) ? "ok" : "not ok", ++test, rss_start, rss_end);
+
+    systemf1_set_allocator(NULL, NULL, NULL, NULL);
+    return 0;
+}
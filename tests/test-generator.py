@@ -12,11 +12,17 @@ template = """
  * DO NOT EDIT THIS FILE.
  */
 
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
 
 #include "../src/systemf.h"
 
@@ -25,6 +31,81 @@ static void sigsegv_handler(int signo) {{
     exit(EXIT_FAILURE);
 }}
 
+/*
+ * Budgets: what the test function costs is written to the file named by
+ * SYSTEMF_TEST_BUDGET for test.test to check.  Allocations are counted by
+ * interposing on glibc's malloc, so they are only counted with glibc and
+ * without a sanitizer that has its own malloc.
+ */
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define BUDGET_ALLOCS 1
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+#endif
+
+static int budget_counting = 0;
+static unsigned long budget_allocs = 0;
+
+#if BUDGET_ALLOCS
+static void budget_alloc(void) {{
+    if (__atomic_load_n(&budget_counting, __ATOMIC_RELAXED)) {{
+        __atomic_add_fetch(&budget_allocs, 1, __ATOMIC_RELAXED);
+    }}
+}}
+
+void *malloc(size_t size) {{
+    budget_alloc();
+    return __libc_malloc(size);
+}}
+
+void *calloc(size_t count, size_t size) {{
+    budget_alloc();
+    return __libc_calloc(count, size);
+}}
+
+void *realloc(void *ptr, size_t size) {{
+    budget_alloc();
+    return __libc_realloc(ptr, size);
+}}
+#endif
+
+static int budget_open_fds(void) {{
+    int count = 0;
+    for (int fd = 0; fd < 1024; fd++) {{
+        count += fcntl(fd, F_GETFD) >= 0;
+    }}
+    return count;
+}}
+
+static int budget_fds;
+
+static void budget_begin(void) {{
+    budget_fds = budget_open_fds();
+    systemf1_stats_reset();
+    __atomic_store_n(&budget_counting, 1, __ATOMIC_RELAXED);
+}}
+
+static void budget_end(void) {{
+    const char *path = getenv("SYSTEMF_TEST_BUDGET");
+    systemf1_stats stats;
+    FILE *file;
+    int fds;
+
+    __atomic_store_n(&budget_counting, 0, __ATOMIC_RELAXED);
+    fds = budget_open_fds() - budget_fds;
+    systemf1_stats_get(&stats);
+    if (!path || !(file = fopen(path, "w"))) {{
+        return;
+    }}
+    fprintf(file, "{{\\"fds\\": %d, \\"processes\\": %llu", fds > 0 ? fds : 0, stats.tasks);
+#if BUDGET_ALLOCS
+    fprintf(file, ", \\"allocs\\": %lu", budget_allocs);
+#endif
+    fprintf(file, "}}\\n");
+    fclose(file);
+}}
+
 static void sanity_check_tests_dir(void) {{
     const size_t bufsize = 4096;
     char *buf = malloc(bufsize);
@@ -79,7 +160,11 @@ int main(int argc, const char *argv[]) {{
         return EXIT_FAILURE;
     }}
 
-    return test_func_table[index - 1]();
+    budget_begin();
+    int ret = test_func_table[index - 1]();
+    fflush(stdout);
+    budget_end();
+    return ret;
 }}
 """
 
@@ -105,7 +190,25 @@ static int {test_name}() {{
 }}
 """
 
+test_code_template = """{test_globals}
+static int {test_name}() {{
+{test_code}
+}}
+"""
+
+def generate_test_code_func(index: int, test: dict) -> str:
+    """Generates a test function from 'code' which is a list of c statements."""
+    test_name = str2func(index, test['description'])
+    # Replace '#' with the string representation of this test number.
+    test_code = "\n".join([f'    {line.replace("#", str(index+1))}' for line in test['code']])
+    # Optional 'globals' are placed at file scope ahead of the test function.
+    test_globals = "".join([f'\n{line.replace("#", str(index+1))}' for line in test.get('globals', [])])
+    return test_code_template.format(test_name=test_name, test_code=test_code, test_globals=test_globals)
+
 def generate_test_func(index: int, test: dict) -> str:
+    if 'code' in test:
+        return generate_test_code_func(index, test)
+
     command = test['command']
     test_name = str2func(index, test['description'])
     test_args = []